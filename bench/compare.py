@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Compares two result files of configparser_bench or configparser_microbench.
+
+usage: compare.py BASE.json NEW.json [--threshold PERCENT] [--all]
+
+Results are matched by suite, name and params. A metric ending in
+"_per_s" is better when higher; seconds, ns_per_op, peak_rss_kb,
+allocations and allocated_bytes are better when lower; the other
+metrics describe the input and are only reported when they differ.
+The exit status is 1 when any metric got worse by more than the
+threshold (5% by default), 2 for files that can not be compared.
+"""
+
+import argparse
+import json
+import sys
+
+SCHEMA = 1
+
+LOWER_IS_BETTER = {"seconds", "ns_per_op", "peak_rss_kb", "allocations", "allocated_bytes"}
+
+
+def higher_is_better(metric):
+    if metric.endswith("_per_s"):
+        return True
+    if metric in LOWER_IS_BETTER:
+        return False
+    return None
+
+
+def load(path):
+    with open(path) as f:
+        doc = json.load(f)
+
+    if doc.get("schema") != SCHEMA:
+        raise ValueError("%s: schema %s, expected %d" % (path, doc.get("schema"), SCHEMA))
+
+    results = {}
+    for r in doc["results"]:
+        key = (doc["suite"], r["name"], tuple(sorted(r["params"].items())))
+        results[key] = r["metrics"]
+
+    return doc, results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compares two benchmark result files.")
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent a metric may get worse before it is a regression")
+    parser.add_argument("--all", action="store_true",
+                        help="also list the metrics within the threshold")
+    args = parser.parse_args()
+
+    base_doc, base = load(args.base)
+    new_doc, new = load(args.new)
+
+    if base_doc["suite"] != new_doc["suite"]:
+        raise ValueError("suites differ: %s / %s" % (base_doc["suite"], new_doc["suite"]))
+    if not base.keys() & new.keys():
+        raise ValueError("no results in common")
+
+    for key in ("compiler", "assertions"):
+        a = base_doc["context"].get(key)
+        b = new_doc["context"].get(key)
+        if a != b:
+            print("note: %s differs: %s / %s" % (key, a, b))
+
+    rows = []
+    regressions = 0
+    for key in sorted(base.keys() & new.keys()):
+        suite, name, _ = key
+        for metric, old_value in base[key].items():
+            if metric not in new[key]:
+                continue
+
+            new_value = new[key][metric]
+            better = higher_is_better(metric)
+
+            if better is None:
+                if old_value != new_value:
+                    rows.append((name, metric, old_value, new_value, "input changed"))
+                continue
+
+            if old_value == 0:
+                continue
+
+            change = (new_value - old_value) / old_value * 100.0
+            worse = -change if better else change
+
+            if worse > args.threshold:
+                regressions += 1
+                verdict = "REGRESSION"
+            elif -worse > args.threshold:
+                verdict = "improved"
+            elif args.all:
+                verdict = ""
+            else:
+                continue
+
+            rows.append((name, metric, old_value, new_value, "%+.1f%% %s" % (change, verdict)))
+
+    for key in sorted(base.keys() - new.keys()):
+        rows.append((key[1], "", "", "", "only in base"))
+    for key in sorted(new.keys() - base.keys()):
+        rows.append((key[1], "", "", "", "only in new"))
+
+    if rows:
+        width = max(len(r[0]) for r in rows)
+        for name, metric, old_value, new_value, verdict in rows:
+            if metric:
+                print("%-*s  %-16s %14s %14s  %s" % (width, name, metric, fmt(old_value), fmt(new_value), verdict))
+            else:
+                print("%-*s  %s" % (width, name, verdict))
+    else:
+        print("no change beyond %.1f%%" % args.threshold)
+
+    return 1 if regressions else 0
+
+
+def fmt(value):
+    if isinstance(value, float):
+        return "%.4g" % value
+    return str(value)
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except (OSError, ValueError, KeyError) as e:
+        print("error: %s" % e, file=sys.stderr)
+        sys.exit(2)
@@ -0,0 +1,419 @@
+#include "generator.h"
+#include <cstdio> // snprintf
+
+namespace configparser
+{
+namespace bench
+{
+
+namespace
+{
+    const char* const WORKLOAD_NAMES[] = {
+        "tiny_sections",
+        "huge_sections",
+        "long_vectors",
+        "escapes",
+        "numeric_tables",
+        "links"
+    };
+
+    static_assert(sizeof(WORKLOAD_NAMES) / sizeof(WORKLOAD_NAMES[0]) == (size_t)Workload::WORKLOAD_NUM,
+        "a name is needed for every workload");
+
+    const char* const SYLLABLES[] = {
+        "ka", "lo", "mer", "te", "son", "vi", "dra", "pul", "ex", "no",
+        "ri", "ban", "cu", "fel", "gi", "hom", "jut", "ness", "or", "qua"
+    };
+
+    const char* const BOOLEANS[] = {
+        "on", "off", "yes", "no", "enabled", "disabled", "y", "n"
+    };
+
+    // links only point to the most recent options,
+    // which keeps huge documents in bounded memory
+    constexpr std::size_t MAX_TARGETS = 4096;
+    // and only to the options with a few values, as linking to
+    // lists of links would double the values at every step
+    constexpr std::size_t MAX_TARGET_VALUES = 8;
+} // anonymous
+
+const char* workload_name(Workload workload)
+{
+    return WORKLOAD_NAMES[(size_t)workload];
+}
+
+bool workload_from_name(std::string_view name, Workload& workload)
+{
+    for (size_t i = 0; i < (size_t)Workload::WORKLOAD_NUM; ++i)
+    {
+        if (name == WORKLOAD_NAMES[i])
+        {
+            workload = (Workload)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::uint64_t random::next()
+{
+    std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+std::size_t random::between(std::size_t lo, std::size_t hi)
+{
+    return lo + (std::size_t)(next() % (hi - lo + 1));
+}
+
+generator::generator(Workload workload, std::uint64_t seed)
+    : m_workload(workload)
+    , m_random(seed)
+{
+}
+
+std::uint64_t generator::next()
+{
+    return m_random.next();
+}
+
+std::size_t generator::between(std::size_t lo, std::size_t hi)
+{
+    return m_random.between(lo, hi);
+}
+
+void generator::generate(std::size_t size, std::string& out)
+{
+    const std::size_t begin_size = out.size();
+    while (out.size() - begin_size < size)
+    {
+        line(out);
+    }
+}
+
+void generator::line(std::string& out)
+{
+    if (m_options_left == 0)
+    {
+        section(out);
+        return;
+    }
+
+    // a few blank and comment lines, as written by hand
+    const std::size_t roll = between(0, 99);
+    if (roll == 0)
+    {
+        out += '\n';
+    }
+    else if (roll == 1)
+    {
+        out += "; ";
+        word(out);
+        out += ' ';
+        word(out);
+        out += '\n';
+    }
+
+    option(out);
+    --m_options_left;
+}
+
+void generator::section(std::string& out)
+{
+    m_section.clear();
+    switch (m_workload)
+    {
+        case Workload::WORKLOAD_TINY_SECTIONS:
+            m_section += "app.";
+            word(m_section);
+            m_section += '.';
+            m_options_left = between(1, 4);
+            break;
+        case Workload::WORKLOAD_HUGE_SECTIONS:
+            m_section += "table";
+            m_options_left = between(50000, 200000);
+            break;
+        case Workload::WORKLOAD_LONG_VECTORS:
+            m_section += "series";
+            m_options_left = between(4, 16);
+            break;
+        case Workload::WORKLOAD_ESCAPES:
+            m_section += "text";
+            m_options_left = between(8, 32);
+            break;
+        case Workload::WORKLOAD_NUMERIC_TABLES:
+            m_section += "row";
+            m_options_left = between(16, 64);
+            break;
+        case Workload::WORKLOAD_LINKS:
+            m_section += "node";
+            m_options_left = between(8, 32);
+            break;
+        default:
+            break;
+    }
+
+    m_section += std::to_string(m_sections++);
+    m_options = 0;
+
+    out += '[';
+    out += m_section;
+    out += "]\n";
+}
+
+void generator::option(std::string& out)
+{
+    const std::string name = "opt" + std::to_string(m_options++);
+    out += name;
+    out += " = ";
+
+    std::size_t values = 1;
+    switch (m_workload)
+    {
+        case Workload::WORKLOAD_TINY_SECTIONS:
+            scalar(out);
+            break;
+        case Workload::WORKLOAD_HUGE_SECTIONS:
+            if (between(0, 9) < 7)
+            {
+                scalar(out);
+            }
+            else
+            {
+                values = between(2, 6);
+                list(out, values, false);
+            }
+            break;
+        case Workload::WORKLOAD_LONG_VECTORS:
+            values = between(100, 1000);
+            list(out, values, between(0, 1) == 0);
+            break;
+        case Workload::WORKLOAD_ESCAPES:
+            values = escaped(out);
+            break;
+        case Workload::WORKLOAD_NUMERIC_TABLES:
+            values = between(8, 32);
+            list(out, values, true);
+            break;
+        case Workload::WORKLOAD_LINKS:
+            values = links(out);
+            break;
+        default:
+            break;
+    }
+
+    out += '\n';
+
+    if (values > MAX_TARGET_VALUES)
+    {
+        return;
+    }
+
+    target t{ m_section + '#' + name, values };
+    if (m_targets.size() < MAX_TARGETS)
+    {
+        m_targets.push_back(std::move(t));
+    }
+    else
+    {
+        m_targets[between(0, MAX_TARGETS - 1)] = std::move(t);
+    }
+}
+
+void generator::word(std::string& out)
+{
+    const std::size_t count = between(1, 4);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out += SYLLABLES[next() % (sizeof(SYLLABLES) / sizeof(SYLLABLES[0]))];
+    }
+}
+
+void generator::scalar(std::string& out)
+{
+    switch (between(0, 9))
+    {
+        case 0:
+        case 1:
+        case 2:
+            number(out);
+            break;
+        case 3:
+            out += BOOLEANS[next() % (sizeof(BOOLEANS) / sizeof(BOOLEANS[0]))];
+            break;
+        default:
+            word(out);
+            for (std::size_t i = between(0, 3); i > 0; --i)
+            {
+                out += ' ';
+                word(out);
+            }
+            break;
+    }
+}
+
+void generator::number(std::string& out)
+{
+    char buffer[64];
+    switch (between(0, 9))
+    {
+        case 0:
+        {
+            const unsigned shift = (unsigned)between(16, 48);
+            snprintf(buffer, sizeof(buffer), "0x%llX", (unsigned long long)(next() >> shift));
+            break;
+        }
+        case 1:
+        {
+            const unsigned shift = (unsigned)between(40, 56);
+            snprintf(buffer, sizeof(buffer), "0%llo", (unsigned long long)(next() >> shift));
+            break;
+        }
+        case 2:
+        {
+            // 0b followed by 1 to 16 bits
+            const std::size_t bits = between(1, 16);
+            std::uint64_t value = next();
+            size_t i = 0;
+            buffer[i++] = '0';
+            buffer[i++] = 'b';
+            for (std::size_t j = 0; j < bits; ++j, value >>= 1)
+            {
+                buffer[i++] = (char)('0' + (value & 1));
+            }
+            buffer[i] = '\0';
+            break;
+        }
+        case 3:
+        case 4:
+        {
+            // drawn one at a time, the order in which
+            // arguments are evaluated is unspecified
+            const bool negative = between(0, 3) == 0;
+            const unsigned long long integer = between(1, 99999);
+            const unsigned long long fraction = between(0, 999999);
+            snprintf(buffer, sizeof(buffer), "%s%llu.%llu", negative ? "-" : "", integer, fraction);
+            break;
+        }
+        case 5:
+        {
+            const unsigned long long integer = between(1, 9);
+            const unsigned long long fraction = between(0, 9999);
+            const bool negative = between(0, 1) == 0;
+            const unsigned long long exponent = between(1, 300);
+            snprintf(buffer, sizeof(buffer), "%llu.%lluE%c%llu", integer, fraction, negative ? '-' : '+', exponent);
+            break;
+        }
+        default:
+        {
+            const bool negative = between(0, 3) == 0;
+            const unsigned shift = (unsigned)between(20, 62);
+            snprintf(buffer, sizeof(buffer), "%s%llu", negative ? "-" : "", (unsigned long long)(next() >> shift) + 1);
+            break;
+        }
+    }
+
+    out += buffer;
+}
+
+std::size_t generator::escaped(std::string& out)
+{
+    // spaces at both ends need escaping, the
+    // ones inside are part of the value anyway
+    const std::size_t items = (between(0, 3) == 0) ? between(2, 4) : 1;
+    for (std::size_t i = 0; i < items; ++i)
+    {
+        if (i != 0)
+        {
+            out += ", ";
+        }
+
+        for (std::size_t j = between(1, 4); j > 0; --j)
+        {
+            out += "\\ ";
+        }
+
+        word(out);
+        for (std::size_t j = between(0, 6); j > 0; --j)
+        {
+            out += ' ';
+            word(out);
+        }
+
+        for (std::size_t j = between(1, 4); j > 0; --j)
+        {
+            out += "\\ ";
+        }
+    }
+
+    if (between(0, 1) == 0)
+    {
+        out += " ; ";
+        word(out);
+    }
+
+    return items;
+}
+
+void generator::list(std::string& out, std::size_t count, bool numbers)
+{
+    const char* sep = (between(0, 3) == 0) ? " : " : ", ";
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+        {
+            out += sep;
+        }
+
+        if (numbers)
+        {
+            number(out);
+        }
+        else
+        {
+            word(out);
+        }
+    }
+}
+
+std::size_t generator::links(std::string& out)
+{
+    // the first options have nothing to link to
+    if (m_targets.size() < 2)
+    {
+        scalar(out);
+        return 1;
+    }
+
+    std::size_t values = 0;
+    const std::size_t count = between(1, 3);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+        {
+            out += ", ";
+        }
+
+        if (between(0, 4) == 0)
+        {
+            word(out);
+            ++values;
+        }
+        else
+        {
+            const target& t = m_targets[next() % m_targets.size()];
+            out += "${";
+            out += t.name;
+            out += '}';
+            values += t.values;
+        }
+    }
+
+    return values;
+}
+
+} // bench
+} // configparser
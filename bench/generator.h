@@ -0,0 +1,97 @@
+#ifndef CP_BENCH_GENERATOR_H
+#define CP_BENCH_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace configparser
+{
+namespace bench
+{
+    enum class Workload
+    {
+        WORKLOAD_TINY_SECTIONS, // many sections of a few short options
+        WORKLOAD_HUGE_SECTIONS, // a few sections of many options
+        WORKLOAD_LONG_VECTORS, // lists of hundreds of items
+        WORKLOAD_ESCAPES, // strings with escaped spaces and comments
+        WORKLOAD_NUMERIC_TABLES, // lists of decimal, hex, octal, binary and float numbers
+        WORKLOAD_LINKS, // options linking to options defined before them
+
+        WORKLOAD_NUM
+    }; // Workload
+
+    const char* workload_name(Workload workload);
+    // false for an unknown name
+    bool workload_from_name(std::string_view name, Workload& workload);
+
+    // splitmix64, as the standard distributions
+    // differ from one library to another
+    class random
+    {
+    public:
+        explicit random(std::uint64_t seed) : m_state(seed) {}
+
+        std::uint64_t next();
+        // uniform in [lo, hi]
+        std::size_t between(std::size_t lo, std::size_t hi);
+
+    private:
+        std::uint64_t m_state;
+    }; // random
+
+    // writes a synthetic document of one workload, the same seed
+    // gives the same text on every platform; every link points to
+    // an option defined before it, so the documents always parse
+    class generator
+    {
+    public:
+        generator(Workload workload, std::uint64_t seed);
+        generator(const generator&) = default;
+        generator(generator&&) = default;
+        generator& operator=(const generator&) = default;
+        generator& operator=(generator&&) = default;
+        ~generator() = default;
+
+        // appends whole lines until out grew by at least size bytes,
+        // called again it continues the same document
+        void generate(std::size_t size, std::string& out);
+
+    private:
+        std::uint64_t next();
+        std::size_t between(std::size_t lo, std::size_t hi);
+
+        void line(std::string& out);
+        void section(std::string& out);
+        void option(std::string& out);
+
+        void word(std::string& out);
+        void scalar(std::string& out);
+        void number(std::string& out);
+        // both return the number of values written
+        std::size_t escaped(std::string& out);
+        std::size_t links(std::string& out);
+        void list(std::string& out, std::size_t count, bool numbers);
+
+        // an option links may point to
+        struct target
+        {
+            std::string name; // "section#option"
+            std::size_t values;
+        }; // target
+
+        Workload m_workload;
+        random m_random;
+        std::size_t m_sections = 0;
+        std::size_t m_options = 0; // in the current section
+        std::size_t m_options_left = 0;
+        std::string m_section;
+        std::vector<target> m_targets;
+    }; // generator
+
+} // bench
+} // configparser
+
+#endif // CP_BENCH_GENERATOR_H
@@ -0,0 +1,377 @@
+#include "generator.h"
+#include "stats.h"
+#include <configparser.h>
+#include <algorithm> // min, max
+#include <chrono>
+#include <cstdio> // remove
+#include <cstdlib> // strtoull
+#include <cstring> // strcmp
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace configparser;
+
+namespace
+{
+    struct settings
+    {
+        std::vector<bench::Workload> workloads;
+        std::vector<std::size_t> sizes;
+        std::uint64_t seed = 1;
+        unsigned runs = 3;
+        unsigned threads = 1;
+        bool arena = false;
+        bool lazy = false;
+        bool view = false;
+        bool from_file = false;
+        std::string write_dir; // the corpora are only written
+    }; // settings
+
+    void usage()
+    {
+        std::cerr <<
+            "usage: configparser_bench [options]\n"
+            "  --workload NAME    one of the workloads below, may be repeated (default: all)\n"
+            "  --size SIZE        bytes of text, with an optional K, M or G suffix,\n"
+            "                     may be repeated (default: 16M)\n"
+            "  --seed N           seed of the generator (default: 1)\n"
+            "  --runs N           parses of every text, the fastest is reported (default: 3)\n"
+            "  --threads N        see ConfigParser::set_thread_count (default: 1)\n"
+            "  --arena            MEMORY_ARENA instead of MEMORY_HEAP\n"
+            "  --lazy             VALUE_LAZY instead of VALUE_EAGER\n"
+            "  --view             DOCUMENT_VIEW instead of DOCUMENT_COPY\n"
+            "  --file             write the text to a file and parse it with parse_file\n"
+            "  --write DIR        only write the texts to DIR as <workload>_<size>.ini,\n"
+            "                     to run other parsers on the same input\n"
+            "workloads:";
+
+        for (size_t i = 0; i < (size_t)bench::Workload::WORKLOAD_NUM; ++i)
+        {
+            std::cerr << ' ' << bench::workload_name((bench::Workload)i);
+        }
+        std::cerr << std::endl;
+    }
+
+    bool parse_size(const char* text, std::size_t& size)
+    {
+        char* end = nullptr;
+        size = (std::size_t)std::strtoull(text, &end, 10);
+
+        switch (*end)
+        {
+            case 'K': case 'k': size <<= 10; ++end; break;
+            case 'M': case 'm': size <<= 20; ++end; break;
+            case 'G': case 'g': size <<= 30; ++end; break;
+            default: break;
+        }
+
+        return (end != text) && (*end == '\0') && (size != 0);
+    }
+
+    std::string size_label(std::size_t size)
+    {
+        if ((size % (1 << 30)) == 0)
+        {
+            return std::to_string(size >> 30) + 'G';
+        }
+
+        if ((size % (1 << 20)) == 0)
+        {
+            return std::to_string(size >> 20) + 'M';
+        }
+
+        if ((size % (1 << 10)) == 0)
+        {
+            return std::to_string(size >> 10) + 'K';
+        }
+
+        return std::to_string(size);
+    }
+
+    bool parse_args(int argc, char* argv[], settings& s)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+            if (strcmp(arg, "--arena") == 0)
+            {
+                s.arena = true;
+            }
+            else if (strcmp(arg, "--lazy") == 0)
+            {
+                s.lazy = true;
+            }
+            else if (strcmp(arg, "--view") == 0)
+            {
+                s.view = true;
+            }
+            else if (strcmp(arg, "--file") == 0)
+            {
+                s.from_file = true;
+            }
+            else if (value == nullptr)
+            {
+                return false;
+            }
+            else
+            {
+                ++i;
+                if (strcmp(arg, "--workload") == 0)
+                {
+                    bench::Workload workload;
+                    if (!bench::workload_from_name(value, workload))
+                    {
+                        return false;
+                    }
+
+                    s.workloads.push_back(workload);
+                }
+                else if (strcmp(arg, "--size") == 0)
+                {
+                    std::size_t size;
+                    if (!parse_size(value, size))
+                    {
+                        return false;
+                    }
+
+                    s.sizes.push_back(size);
+                }
+                else if (strcmp(arg, "--seed") == 0)
+                {
+                    s.seed = std::strtoull(value, nullptr, 10);
+                }
+                else if (strcmp(arg, "--runs") == 0)
+                {
+                    s.runs = std::max(1u, (unsigned)std::strtoul(value, nullptr, 10));
+                }
+                else if (strcmp(arg, "--threads") == 0)
+                {
+                    s.threads = (unsigned)std::strtoul(value, nullptr, 10);
+                }
+                else if (strcmp(arg, "--write") == 0)
+                {
+                    s.write_dir = value;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (s.workloads.empty())
+        {
+            for (size_t i = 0; i < (size_t)bench::Workload::WORKLOAD_NUM; ++i)
+            {
+                s.workloads.push_back((bench::Workload)i);
+            }
+        }
+
+        if (s.sizes.empty())
+        {
+            s.sizes.push_back(16 << 20);
+        }
+
+        return true;
+    }
+
+    // multi-GB texts go to the file a few MB at a time
+    bool write_text(const std::string& path, bench::Workload workload,
+        std::uint64_t seed, std::size_t size, std::size_t& written)
+    {
+        std::ofstream out(path, std::ios::binary);
+        bench::generator gen(workload, seed);
+        std::string chunk;
+
+        written = 0;
+        while (out && (written < size))
+        {
+            chunk.clear();
+            gen.generate(std::min<std::size_t>(size - written, 4 << 20), chunk);
+            out.write(chunk.data(), (std::streamsize)chunk.size());
+            written += chunk.size();
+        }
+
+        return (bool)out;
+    }
+
+    struct document_counts
+    {
+        std::size_t sections = 0;
+        std::size_t options = 0;
+        std::size_t values = 0;
+    }; // document_counts
+
+    document_counts count(const ConfigParser& p)
+    {
+        document_counts counts;
+        for (const section_type& sct : p.sections())
+        {
+            ++counts.sections;
+            for (const option_type& opt : sct.options())
+            {
+                ++counts.options;
+                counts.values += opt.size();
+            }
+        }
+
+        return counts;
+    }
+
+    bool run(const settings& s, bench::Workload workload, std::size_t size, bench::report& rep)
+    {
+        const std::string name = std::string(bench::workload_name(workload)) + '_' + size_label(size);
+        const std::string path = "configparser_bench_" + name + ".ini";
+
+        std::string text;
+        std::size_t bytes = 0;
+        if (s.from_file)
+        {
+            if (!write_text(path, workload, s.seed, size, bytes))
+            {
+                std::cerr << "could not write " << path << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            bench::generator gen(workload, s.seed);
+            text.reserve(size + 64 * 1024);
+            gen.generate(size, text);
+            bytes = text.size();
+        }
+
+        double best_seconds = 0.0;
+        std::size_t peak_kb = 0;
+        bench::alloc_counts allocs;
+        document_counts counts;
+
+        for (unsigned run = 0; run < s.runs; ++run)
+        {
+            ConfigParser p;
+            p.set_memory_mode(s.arena ? MemoryMode::MEMORY_ARENA : MemoryMode::MEMORY_HEAP);
+            p.set_value_mode(s.lazy ? ValueMode::VALUE_LAZY : ValueMode::VALUE_EAGER);
+            p.set_document_mode(s.view ? DocumentMode::DOCUMENT_VIEW : DocumentMode::DOCUMENT_COPY);
+            p.set_thread_count(s.threads);
+
+            bench::reset_peak_rss();
+            const bench::alloc_counts before = bench::allocations();
+            const auto start = std::chrono::steady_clock::now();
+
+            const bool ok = s.from_file ? p.parse_file(path.c_str()) : p.parse_text(text.c_str());
+
+            const auto stop = std::chrono::steady_clock::now();
+            const bench::alloc_counts after = bench::allocations();
+
+            if (!ok)
+            {
+                std::cerr << name << ": parse failed at line " << p.get_error_line()
+                    << ", column " << p.get_error_column() << std::endl;
+                std::remove(path.c_str());
+                return false;
+            }
+
+            // every metric is taken from the fastest run
+            const double seconds = std::chrono::duration<double>(stop - start).count();
+            if ((run == 0) || (seconds < best_seconds))
+            {
+                best_seconds = seconds;
+                peak_kb = bench::peak_rss_kb();
+                allocs.count = after.count - before.count;
+                allocs.bytes = after.bytes - before.bytes;
+                counts = count(p);
+            }
+        }
+
+        if (s.from_file)
+        {
+            std::remove(path.c_str());
+        }
+
+        bench::result r;
+        r.name = std::string(bench::workload_name(workload)) + '/' + size_label(size);
+        r.params = {
+            { "workload", bench::workload_name(workload) },
+            { "size", size_label(size) },
+            { "seed", std::to_string(s.seed) },
+            { "source", s.from_file ? "file" : "text" },
+            { "memory", s.arena ? "arena" : "heap" },
+            { "values", s.lazy ? "lazy" : "eager" },
+            { "document", s.view ? "view" : "copy" },
+            { "threads", std::to_string(s.threads) }
+        };
+        r.metrics = {
+            { "bytes", (double)bytes },
+            { "sections", (double)counts.sections },
+            { "options", (double)counts.options },
+            { "values", (double)counts.values },
+            { "seconds", best_seconds },
+            { "mb_per_s", (double)bytes / 1e6 / best_seconds },
+            { "values_per_s", (double)counts.values / best_seconds },
+            { "peak_rss_kb", (double)peak_kb },
+            { "allocations", (double)allocs.count },
+            { "allocated_bytes", (double)allocs.bytes }
+        };
+        rep.add(std::move(r));
+
+        return true;
+    }
+
+    bool write_corpora(const settings& s)
+    {
+        for (const bench::Workload workload : s.workloads)
+        {
+            for (const std::size_t size : s.sizes)
+            {
+                const std::string path = s.write_dir + '/' + bench::workload_name(workload) + '_' + size_label(size) + ".ini";
+
+                std::size_t written;
+                if (!write_text(path, workload, s.seed, size, written))
+                {
+                    std::cerr << "could not write " << path << std::endl;
+                    return false;
+                }
+
+                std::cerr << path << ": " << written << " bytes" << std::endl;
+            }
+        }
+
+        return true;
+    }
+} // anonymous
+
+int main(int argc, char* argv[])
+{
+    settings s;
+    if (!parse_args(argc, argv, s))
+    {
+        usage();
+        return 2;
+    }
+
+    if (!s.write_dir.empty())
+    {
+        return write_corpora(s) ? 0 : 1;
+    }
+
+    bench::report rep("parse");
+
+    for (const bench::Workload workload : s.workloads)
+    {
+        for (const std::size_t size : s.sizes)
+        {
+            if (!run(s, workload, size, rep))
+            {
+                return 1;
+            }
+        }
+    }
+
+    rep.write(std::cout);
+
+    return 0;
+}
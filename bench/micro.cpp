@@ -0,0 +1,638 @@
+#include "generator.h"
+#include "stats.h"
+#include <configparser.h>
+#include <tokenizer.h>
+#include <utils.h> // remove_escapes
+#include <value_parser.h>
+#include <algorithm> // max, min
+#include <chrono>
+#include <cstdlib> // strtoull, strtod
+#include <cstring> // strcmp
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace configparser;
+
+namespace
+{
+    struct settings
+    {
+        std::uint64_t seed = 1;
+        unsigned runs = 5;
+        double min_seconds = 0.1;
+        std::size_t text_size = 4 << 20; // for the tokenizer
+        std::size_t document_size = 1 << 20; // for the lookups
+        std::string filter;
+    }; // settings
+
+    // the inputs of one benchmark, cycled through in order
+    constexpr std::size_t INPUT_COUNT = 4096;
+
+    // keeps the results from being optimized away
+    volatile std::size_t g_sink;
+
+    void usage()
+    {
+        std::cerr <<
+            "usage: configparser_microbench [options]\n"
+            "  --filter TEXT      only the benchmarks with TEXT in their name\n"
+            "  --seed N           seed of the inputs (default: 1)\n"
+            "  --runs N           timed runs of every benchmark, the fastest\n"
+            "                     is reported (default: 5)\n"
+            "  --min-time S       seconds a run lasts at least (default: 0.1)\n"
+            "  --size SIZE        bytes of text for the tokenizer (default: 4M)\n"
+            << std::endl;
+    }
+
+    bool parse_args(int argc, char* argv[], settings& s)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char* arg = argv[i];
+            const char* value = argv[i + 1];
+
+            if (strcmp(arg, "--filter") == 0)
+            {
+                s.filter = value;
+            }
+            else if (strcmp(arg, "--seed") == 0)
+            {
+                s.seed = std::strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(arg, "--runs") == 0)
+            {
+                s.runs = std::max(1u, (unsigned)std::strtoul(value, nullptr, 10));
+            }
+            else if (strcmp(arg, "--min-time") == 0)
+            {
+                s.min_seconds = std::strtod(value, nullptr);
+            }
+            else if (strcmp(arg, "--size") == 0)
+            {
+                char* end = nullptr;
+                s.text_size = (std::size_t)std::strtoull(value, &end, 10);
+                switch (*end)
+                {
+                    case 'K': case 'k': s.text_size <<= 10; break;
+                    case 'M': case 'm': s.text_size <<= 20; break;
+                    default: break;
+                }
+
+                if (s.text_size == 0)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return (argc % 2) == 1;
+    }
+
+    // inputs stored back to back, as in a document
+    class input_set
+    {
+    public:
+        void add(const std::string& input)
+        {
+            m_offsets.emplace_back(m_text.size(), input.size());
+            m_text += input;
+            m_text += '\0';
+        }
+
+        std::size_t size() const { return m_offsets.size(); }
+
+        // valid until the next add()
+        std::string_view operator[](std::size_t idx) const
+        {
+            return { m_text.data() + m_offsets[idx].first, m_offsets[idx].second };
+        }
+
+    private:
+        std::string m_text;
+        std::vector<std::pair<std::size_t, std::size_t>> m_offsets;
+    }; // input_set
+
+    class runner
+    {
+    public:
+        runner(const settings& s, bench::report& rep) : m_settings(s), m_report(rep) {}
+
+        bool wants(const std::string& name) const
+        {
+            return m_settings.filter.empty() || (name.find(m_settings.filter) != std::string::npos);
+        }
+
+        // calls of body are repeated until a run lasts
+        // min_seconds, the fastest run gives the result
+        template <typename Body>
+        double seconds_per_call(Body body) const
+        {
+            using clock = std::chrono::steady_clock;
+
+            std::size_t calls = 1;
+            double best = 0.0;
+            for (unsigned run = 0; run < m_settings.runs; )
+            {
+                const auto start = clock::now();
+                std::size_t sink = 0;
+                for (std::size_t i = 0; i < calls; ++i)
+                {
+                    sink += body();
+                }
+                const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+                g_sink = sink;
+
+                // too short to time, more calls per run
+                if (seconds < m_settings.min_seconds)
+                {
+                    const double scale = (seconds > 0.0) ? (m_settings.min_seconds / seconds) * 1.2 : 10.0;
+                    calls = (std::size_t)((double)calls * std::min(scale, 100.0)) + 1;
+                    continue;
+                }
+
+                const double per_call = seconds / (double)calls;
+                if ((run == 0) || (per_call < best))
+                {
+                    best = per_call;
+                }
+                ++run;
+            }
+
+            return best;
+        }
+
+        // every element of inputs is one operation
+        template <typename Op>
+        void per_input(const std::string& name, std::vector<std::pair<std::string, std::string>> params,
+            const input_set& inputs, Op op)
+        {
+            if (!wants(name))
+            {
+                return;
+            }
+
+            const double seconds = seconds_per_call([&inputs, &op]() {
+                std::size_t sink = 0;
+                for (std::size_t i = 0; i < inputs.size(); ++i)
+                {
+                    sink += op(inputs[i]);
+                }
+                return sink;
+            });
+
+            const double ns = seconds * 1e9 / (double)inputs.size();
+
+            bench::result r;
+            r.name = name;
+            r.params = std::move(params);
+            r.metrics = {
+                { "ns_per_op", ns },
+                { "ops_per_s", 1e9 / ns }
+            };
+            add(std::move(r));
+        }
+
+        void add(bench::result r)
+        {
+            r.params.insert(r.params.begin(), { "seed", std::to_string(m_settings.seed) });
+            std::cerr << r.name << std::endl;
+            m_report.add(std::move(r));
+        }
+
+        const settings& config() const { return m_settings; }
+
+    private:
+        const settings& m_settings;
+        bench::report& m_report;
+    }; // runner
+
+    std::string word(bench::random& rnd, std::size_t min_length, std::size_t max_length)
+    {
+        static const char LETTERS[] = "abcdefghijklmnopqrstuvwxyz_";
+
+        std::string str;
+        const std::size_t length = rnd.between(min_length, max_length);
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            str += LETTERS[rnd.next() % (sizeof(LETTERS) - 1)];
+        }
+
+        return str;
+    }
+
+    std::string digits(bench::random& rnd, const char* alphabet, std::size_t min_count, std::size_t max_count)
+    {
+        const std::size_t base = strlen(alphabet);
+        const std::size_t count = rnd.between(min_count, max_count);
+
+        // no leading 0, which would make it octal
+        std::string str(1, alphabet[1 + rnd.next() % (base - 1)]);
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            str += alphabet[rnd.next() % base];
+        }
+
+        return str;
+    }
+
+    enum class NumberKind
+    {
+        NUMBER_DECIMAL_SHORT,
+        NUMBER_DECIMAL_LONG,
+        NUMBER_NEGATIVE,
+        NUMBER_HEX,
+        NUMBER_OCTAL,
+        NUMBER_BINARY,
+        NUMBER_FLOAT,
+        NUMBER_EXPONENT,
+        NUMBER_MIXED,
+        NUMBER_NOT_NUMBER,
+
+        NUMBER_NUM
+    }; // NumberKind
+
+    const char* const NUMBER_KIND_NAMES[] = {
+        "decimal_short", // 1 to 4 digits
+        "decimal_long", // 10 to 18 digits
+        "negative",
+        "hex",
+        "octal",
+        "binary",
+        "float",
+        "exponent",
+        "mixed", // all of the above
+        "not_number" // words, as string values
+    };
+
+    std::string number(bench::random& rnd, NumberKind kind)
+    {
+        static const char DECIMAL[] = "0123456789";
+
+        switch (kind)
+        {
+            case NumberKind::NUMBER_DECIMAL_SHORT:
+                return digits(rnd, DECIMAL, 1, 4);
+            case NumberKind::NUMBER_DECIMAL_LONG:
+                return digits(rnd, DECIMAL, 10, 18);
+            case NumberKind::NUMBER_NEGATIVE:
+                return '-' + digits(rnd, DECIMAL, 1, 9);
+            case NumberKind::NUMBER_HEX:
+                return "0x" + digits(rnd, "0123456789abcdefABCDEF", 1, 15);
+            case NumberKind::NUMBER_OCTAL:
+                return '0' + digits(rnd, "01234567", 1, 10);
+            case NumberKind::NUMBER_BINARY:
+                return "0b" + digits(rnd, "01", 1, 32);
+            case NumberKind::NUMBER_FLOAT:
+            {
+                const std::string str = digits(rnd, DECIMAL, 1, 5) + '.';
+                return str + digits(rnd, DECIMAL, 1, 6);
+            }
+            case NumberKind::NUMBER_EXPONENT:
+            {
+                std::string str = digits(rnd, DECIMAL, 1, 1) + '.';
+                str += digits(rnd, DECIMAL, 1, 6);
+                str += (rnd.next() % 2 == 0) ? "e+" : "e-";
+                return str + digits(rnd, DECIMAL, 1, 2);
+            }
+            case NumberKind::NUMBER_MIXED:
+                return number(rnd, (NumberKind)(rnd.next() % (std::size_t)NumberKind::NUMBER_MIXED));
+            default:
+                return word(rnd, 3, 12);
+        }
+    }
+
+    void number_benchmarks(runner& r)
+    {
+        for (std::size_t k = 0; k < (std::size_t)NumberKind::NUMBER_NUM; ++k)
+        {
+            bench::random rnd(r.config().seed);
+            input_set inputs;
+            for (std::size_t i = 0; i < INPUT_COUNT; ++i)
+            {
+                inputs.add(number(rnd, (NumberKind)k));
+            }
+
+            r.per_input(std::string("number_parser/") + NUMBER_KIND_NAMES[k], { { "inputs", NUMBER_KIND_NAMES[k] } },
+                inputs, [](std::string_view input) {
+                    detail::number_parser np;
+                    return (std::size_t)np.parse(input.data(), (std::ptrdiff_t)input.size());
+                });
+        }
+    }
+
+    void boolean_benchmarks(runner& r)
+    {
+        static const char* const WORDS[] = {
+            "on", "off", "yes", "no", "enabled", "disabled", "y", "n", "t", "f",
+            "On", "OFF", "Yes", "NO", "Enabled", "DISABLED"
+        };
+        static const char* const USER_WORDS[] = { "ja", "nein", "oui", "non" };
+
+        bench::random rnd(r.config().seed);
+        input_set builtin;
+        input_set user;
+        input_set words;
+        for (std::size_t i = 0; i < INPUT_COUNT; ++i)
+        {
+            builtin.add(WORDS[rnd.next() % (sizeof(WORDS) / sizeof(WORDS[0]))]);
+            user.add(USER_WORDS[rnd.next() % (sizeof(USER_WORDS) / sizeof(USER_WORDS[0]))]);
+            words.add(word(rnd, 3, 12));
+        }
+
+        const auto parse = [](std::string_view input) {
+            detail::boolean_parser bp;
+            return (std::size_t)bp.parse(input.data(), (std::ptrdiff_t)input.size());
+        };
+
+        r.per_input("boolean_parser/builtin", { { "inputs", "builtin" } }, builtin, parse);
+        r.per_input("boolean_parser/not_boolean", { { "inputs", "not_boolean" } }, words, parse);
+
+        std::shared_ptr<const detail::boolean_words> user_words;
+        for (std::size_t i = 0; i < sizeof(USER_WORDS) / sizeof(USER_WORDS[0]); ++i)
+        {
+            user_words = detail::add_boolean_word(user_words, USER_WORDS[i], (i % 2) == 0);
+        }
+
+        r.per_input("boolean_parser/user_words", { { "inputs", "user_words" } }, user,
+            [&user_words](std::string_view input) {
+                detail::boolean_parser bp(user_words.get());
+                return (std::size_t)bp.parse(input.data(), (std::ptrdiff_t)input.size());
+            });
+    }
+
+    void link_benchmarks(runner& r)
+    {
+        bench::random rnd(r.config().seed);
+        input_set short_links;
+        input_set long_links;
+        input_set spaced_links;
+        input_set not_links;
+        // the names are drawn one per statement, the order in
+        // which operands are evaluated is unspecified
+        const auto link = [&rnd](const char* open, std::size_t min_length, std::size_t max_length,
+            const char* close) {
+            std::string str = open + word(rnd, min_length, max_length);
+            str += '#';
+            str += word(rnd, min_length, max_length);
+            return str + close;
+        };
+
+        for (std::size_t i = 0; i < INPUT_COUNT; ++i)
+        {
+            short_links.add(link("${", 1, 8, "}"));
+            long_links.add(link("${", 20, 40, "}"));
+            spaced_links.add(link("${ ", 4, 12, " }"));
+            not_links.add((i % 2 == 0) ? word(rnd, 3, 12) : number(rnd, NumberKind::NUMBER_MIXED));
+        }
+
+        const auto parse = [](std::string_view input) {
+            detail::link_parser lp;
+            return (std::size_t)lp.parse(input.data(), (std::ptrdiff_t)input.size());
+        };
+
+        r.per_input("link_parser/short", { { "inputs", "short" } }, short_links, parse);
+        r.per_input("link_parser/long", { { "inputs", "long" } }, long_links, parse);
+        r.per_input("link_parser/spaced", { { "inputs", "spaced" } }, spaced_links, parse);
+        r.per_input("link_parser/not_link", { { "inputs", "not_link" } }, not_links, parse);
+    }
+
+    void escape_benchmarks(runner& r)
+    {
+        struct length_class
+        {
+            const char* name;
+            std::size_t min_length;
+            std::size_t max_length;
+        }; // length_class
+
+        static const length_class LENGTHS[] = {
+            { "short", 4, 16 },
+            { "medium", 32, 128 },
+            { "long", 512, 2048 }
+        };
+
+        for (const length_class& length : LENGTHS)
+        {
+            bench::random rnd(r.config().seed);
+            input_set plain;
+            input_set escaped;
+            for (std::size_t i = 0; i < INPUT_COUNT; ++i)
+            {
+                plain.add(word(rnd, length.min_length, length.max_length));
+
+                const std::size_t leading = rnd.between(1, 3);
+                const std::size_t trailing = rnd.between(1, 3);
+                std::string str;
+                for (std::size_t j = 0; j < leading; ++j)
+                {
+                    str += "\\ ";
+                }
+                str += word(rnd, length.min_length, length.max_length);
+                for (std::size_t j = 0; j < trailing; ++j)
+                {
+                    str += "\\ ";
+                }
+                escaped.add(str);
+            }
+
+            // the copy is part of every operation, as
+            // remove_escapes takes the string over
+            const auto remove = [](std::string_view input) {
+                return detail::remove_escapes(std::string{ input }).size();
+            };
+
+            r.per_input(std::string("remove_escapes/plain_") + length.name,
+                { { "inputs", "plain" }, { "length", length.name } }, plain, remove);
+            r.per_input(std::string("remove_escapes/escaped_") + length.name,
+                { { "inputs", "escaped" }, { "length", length.name } }, escaped, remove);
+        }
+    }
+
+    class counting_sink : public detail::token_sink
+    {
+    public:
+        void on_token(const detail::token& t) override
+        {
+            ++m_count;
+            m_bytes += (std::size_t)t.length;
+        }
+
+        std::size_t m_count = 0;
+        std::size_t m_bytes = 0;
+    }; // counting_sink
+
+    void tokenizer_benchmarks(runner& r)
+    {
+        const settings& s = r.config();
+        for (std::size_t w = 0; w < (std::size_t)bench::Workload::WORKLOAD_NUM; ++w)
+        {
+            const bench::Workload workload = (bench::Workload)w;
+            const std::string name = std::string("tokenizer/") + bench::workload_name(workload);
+            if (!r.wants(name))
+            {
+                continue;
+            }
+
+            std::string text;
+            bench::generator gen(workload, s.seed);
+            gen.generate(s.text_size, text);
+
+            std::size_t tokens = 0;
+            const double seconds = r.seconds_per_call([&text, &tokens]() {
+                counting_sink sink;
+                detail::tokenizer tok;
+                tok.parse(text.c_str(), sink);
+                tokens = sink.m_count;
+                return sink.m_bytes;
+            });
+
+            bench::result res;
+            res.name = name;
+            res.params = {
+                { "workload", bench::workload_name(workload) },
+                { "bytes", std::to_string(text.size()) }
+            };
+            res.metrics = {
+                { "mb_per_s", (double)text.size() / 1e6 / seconds },
+                { "tokens_per_s", (double)tokens / seconds },
+                { "ns_per_op", seconds * 1e9 / (double)tokens }
+            };
+            r.add(std::move(res));
+        }
+    }
+
+    void lookup_benchmarks(runner& r)
+    {
+        const settings& s = r.config();
+
+        // many small sections, then a few large ones
+        static const bench::Workload WORKLOADS[] = {
+            bench::Workload::WORKLOAD_TINY_SECTIONS,
+            bench::Workload::WORKLOAD_HUGE_SECTIONS
+        };
+
+        for (const bench::Workload workload : WORKLOADS)
+        {
+            const std::string prefix = std::string("lookup/") + bench::workload_name(workload);
+            if (!r.wants(prefix))
+            {
+                continue;
+            }
+
+            std::string text;
+            bench::generator gen(workload, s.seed);
+            gen.generate(s.document_size, text);
+
+            ConfigParser p;
+            if (!p.parse_text(text.c_str()))
+            {
+                std::cerr << prefix << ": parse failed" << std::endl;
+                continue;
+            }
+
+            // names in random order, so lookups do not follow the document
+            bench::random rnd(s.seed);
+            std::vector<std::pair<std::string, std::string>> hits;
+            for (std::size_t i = 0; i < INPUT_COUNT; ++i)
+            {
+                const section_type& sct = p.sections()[rnd.next() % p.sections().size()];
+                const option_type& opt = sct.options()[rnd.next() % sct.options().size()];
+                hits.emplace_back(std::string{ sct.name() }, std::string{ opt.name() });
+            }
+
+            std::vector<std::pair<std::string, std::string>> missing_options;
+            std::vector<std::pair<std::string, std::string>> missing_sections;
+            for (const auto& hit : hits)
+            {
+                missing_options.emplace_back(hit.first, hit.second + "_missing");
+                missing_sections.emplace_back(hit.first + "_missing", hit.second);
+            }
+
+            const auto run = [&r, &prefix](const char* name, const char* frozen,
+                const std::vector<std::pair<std::string, std::string>>& keys, auto op) {
+                const std::string full_name = prefix + '/' + name + (frozen[0] == 'y' ? "_frozen" : "");
+                if (!r.wants(full_name))
+                {
+                    return;
+                }
+
+                const double seconds = r.seconds_per_call([&keys, &op]() {
+                    std::size_t sink = 0;
+                    for (const auto& key : keys)
+                    {
+                        sink += op(key.first, key.second);
+                    }
+                    return sink;
+                });
+
+                const double ns = seconds * 1e9 / (double)keys.size();
+
+                bench::result res;
+                res.name = full_name;
+                res.params = { { "lookup", name }, { "frozen", frozen } };
+                res.metrics = {
+                    { "ns_per_op", ns },
+                    { "ops_per_s", 1e9 / ns }
+                };
+                r.add(std::move(res));
+            };
+
+            for (const char* frozen : { "no", "yes" })
+            {
+                if (frozen[0] == 'y')
+                {
+                    p.freeze();
+                }
+
+                run("find_option_hit", frozen, hits, [&p](std::string_view sct, std::string_view opt) {
+                    return (std::size_t)(p.find_option(sct, opt) != nullptr);
+                });
+                run("find_option_missing_option", frozen, missing_options, [&p](std::string_view sct, std::string_view opt) {
+                    return (std::size_t)(p.find_option(sct, opt) != nullptr);
+                });
+                run("find_option_missing_section", frozen, missing_sections, [&p](std::string_view sct, std::string_view opt) {
+                    return (std::size_t)(p.find_option(sct, opt) != nullptr);
+                });
+                run("has_section_hit", frozen, hits, [&p](std::string_view sct, std::string_view) {
+                    return (std::size_t)p.has_section(sct);
+                });
+                run("has_section_missing", frozen, missing_sections, [&p](std::string_view sct, std::string_view) {
+                    return (std::size_t)p.has_section(sct);
+                });
+                run("option_hit", frozen, hits, [&p](std::string_view sct, std::string_view opt) {
+                    return p.option(sct, opt).size();
+                });
+            }
+        }
+    }
+} // anonymous
+
+int main(int argc, char* argv[])
+{
+    settings s;
+    if (!parse_args(argc, argv, s))
+    {
+        usage();
+        return 2;
+    }
+
+    bench::report rep("micro");
+
+    runner r(s, rep);
+    tokenizer_benchmarks(r);
+    link_benchmarks(r);
+    number_benchmarks(r);
+    boolean_benchmarks(r);
+    escape_benchmarks(r);
+    lookup_benchmarks(r);
+
+    rep.write(std::cout);
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include "stats.h"
+#include <atomic>
+#include <cstdio> // snprintf
+#include <cstdlib> // malloc, free
+#include <fstream>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h> // GetProcessMemoryInfo
+#else
+#include <sys/resource.h> // getrusage
+#endif
+
+namespace
+{
+    std::atomic<std::uint64_t> g_alloc_count{ 0 };
+    std::atomic<std::uint64_t> g_alloc_bytes{ 0 };
+
+    void* counted_alloc(std::size_t size)
+    {
+        g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+        g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc((size != 0) ? size : 1);
+    }
+} // anonymous
+
+// every allocation of the benchmarks is counted here; the
+// over-aligned ones keep the library's own operator new
+void* operator new(std::size_t size)
+{
+    void* ptr = counted_alloc(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace configparser
+{
+namespace bench
+{
+
+namespace
+{
+    void write_string(std::ostream& out, const std::string& str)
+    {
+        out << '"';
+        for (const char c : str)
+        {
+            if ((c == '"') || (c == '\\'))
+            {
+                out << '\\' << c;
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned)c);
+                out << buffer;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    void write_number(std::ostream& out, double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", value);
+        out << buffer;
+    }
+
+    void write_params(std::ostream& out, const std::vector<std::pair<std::string, std::string>>& params)
+    {
+        out << '{';
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            out << ((i != 0) ? ", " : " ");
+            write_string(out, params[i].first);
+            out << ": ";
+            write_string(out, params[i].second);
+        }
+        out << (params.empty() ? "}" : " }");
+    }
+} // anonymous
+
+alloc_counts allocations() noexcept
+{
+    alloc_counts counts;
+    counts.count = g_alloc_count.load(std::memory_order_relaxed);
+    counts.bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void reset_peak_rss() noexcept
+{
+#if defined(__linux__)
+    // 5 resets the peak to the current size
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+std::size_t peak_rss_kb() noexcept
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+
+    return 0;
+#else
+#if defined(__linux__)
+    // VmHWM follows reset_peak_rss(), ru_maxrss does not
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return (std::size_t)std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+#endif
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+#if defined(__APPLE__)
+    return (std::size_t)usage.ru_maxrss / 1024; // in bytes
+#else
+    return (std::size_t)usage.ru_maxrss;
+#endif
+#endif
+}
+
+report::report(std::string suite)
+    : m_suite(std::move(suite))
+{
+#if defined(__clang__)
+    add_context("compiler", "clang " __clang_version__);
+#elif defined(__GNUC__)
+    add_context("compiler", "gcc " __VERSION__);
+#elif defined(_MSC_VER)
+    add_context("compiler", "msvc " + std::to_string(_MSC_VER));
+#endif
+#ifdef NDEBUG
+    add_context("assertions", "off");
+#else
+    add_context("assertions", "on");
+#endif
+}
+
+void report::add_context(std::string key, std::string value)
+{
+    m_context.emplace_back(std::move(key), std::move(value));
+}
+
+void report::add(result r)
+{
+    m_results.push_back(std::move(r));
+}
+
+void report::write(std::ostream& out) const
+{
+    out << "{\n  \"schema\": " << SCHEMA << ",\n  \"suite\": ";
+    write_string(out, m_suite);
+    out << ",\n  \"context\": ";
+    write_params(out, m_context);
+    out << ",\n  \"results\": [";
+
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const result& r = m_results[i];
+        out << ((i != 0) ? ",\n" : "\n") << "    { \"name\": ";
+        write_string(out, r.name);
+        out << ", \"params\": ";
+        write_params(out, r.params);
+        out << ",\n      \"metrics\": {";
+
+        for (size_t j = 0; j < r.metrics.size(); ++j)
+        {
+            out << ((j != 0) ? ", " : " ");
+            write_string(out, r.metrics[j].first);
+            out << ": ";
+            write_number(out, r.metrics[j].second);
+        }
+        out << " } }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+} // bench
+} // configparser
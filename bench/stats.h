@@ -0,0 +1,76 @@
+#ifndef CP_BENCH_STATS_H
+#define CP_BENCH_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace configparser
+{
+namespace bench
+{
+    // what went through the global operator new since the start
+    struct alloc_counts
+    {
+        std::uint64_t count = 0;
+        std::uint64_t bytes = 0;
+    }; // alloc_counts
+
+    alloc_counts allocations() noexcept;
+
+    // the peak resident set size in KB; it is only reset
+    // on linux, elsewhere it is the peak of the process
+    void reset_peak_rss() noexcept;
+    std::size_t peak_rss_kb() noexcept;
+
+    struct result
+    {
+        std::string name; // unique within a suite, e.g. "links/16M"
+        std::vector<std::pair<std::string, std::string>> params;
+        // metrics ending in "_per_s" are better when higher; seconds,
+        // ns_per_op, peak_rss_kb, allocations and allocated_bytes when
+        // lower; the others describe the input (see compare.py)
+        std::vector<std::pair<std::string, double>> metrics;
+    }; // result
+
+    // the results of a suite, written as
+    // {
+    //   "schema": 1,
+    //   "suite": "parse",
+    //   "context": { "compiler": "...", ... },
+    //   "results": [
+    //     { "name": "...", "params": { "...": "..." }, "metrics": { "...": 1.5 } }
+    //   ]
+    // }
+    // the schema number changes when the layout does
+    class report
+    {
+    public:
+        static constexpr int SCHEMA = 1;
+
+        // the context starts with the compiler and assertions
+        explicit report(std::string suite);
+        report(const report&) = default;
+        report(report&&) = default;
+        report& operator=(const report&) = default;
+        report& operator=(report&&) = default;
+        ~report() = default;
+
+        void add_context(std::string key, std::string value);
+        void add(result r);
+
+        void write(std::ostream& out) const;
+
+    private:
+        std::string m_suite;
+        std::vector<std::pair<std::string, std::string>> m_context;
+        std::vector<result> m_results;
+    }; // report
+
+} // bench
+} // configparser
+
+#endif // CP_BENCH_STATS_H
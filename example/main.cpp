@@ -91,6 +91,15 @@ int main(int argc, char* argv[])
             case configparser::ErrorCode::UNEXPECTED_TOKEN:
                 std::cerr << "Unexpected token." << std::endl;
                 break;
+            case configparser::ErrorCode::LINK_CYCLE:
+                std::cerr << "Link is part of a cycle." << std::endl;
+                break;
+            case configparser::ErrorCode::NUMBER_OUT_OF_RANGE:
+                std::cerr << "Number out of range." << std::endl;
+                break;
+            case configparser::ErrorCode::READ_ERROR:
+                std::cerr << "Configuration file could not be read." << std::endl;
+                break;
             default:
                 std::cerr << "Unknown error." << std::endl;
                 break;
@@ -0,0 +1,43 @@
+#ifndef CP_BATCH_H
+#define CP_BATCH_H
+
+#include "configparser.h"
+#include <string>
+#include <vector>
+
+namespace configparser
+{
+
+    // a file to load, or a text already in memory
+    struct batch_input
+    {
+        static batch_input from_file(std::string path);
+        static batch_input from_text(std::string name, std::string text);
+
+        std::string name; // the path of a file
+        std::string text;
+        bool is_file = false;
+    }; // batch_input
+
+    struct batch_result
+    {
+        std::string name;
+        ConfigParser parser;
+        bool ok = false; // the error is reported by the parser
+    }; // batch_result
+
+    // parses every input with a parser of its own, taking the settings
+    // (but not the document or thread count) of settings, so that all
+    // the inputs share its interner, if any, on a pool of
+    // thread_count threads (0 for all hardware threads); inputs are
+    // parsed one after the other unless the memory resource is the
+    // default heap, as others need not be thread safe; the largest
+    // inputs are started first, so a few huge ones do not end up last
+    // behind many small ones; a failed input does not stop the others
+    // and the results are in the order of the inputs
+    std::vector<batch_result> parse_batch(const std::vector<batch_input>& inputs,
+        const ConfigParser& settings = ConfigParser(), unsigned thread_count = 0);
+
+} // configparser
+
+#endif // CP_BATCH_H
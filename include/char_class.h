@@ -0,0 +1,90 @@
+#ifndef CP_CHAR_CLASS_H
+#define CP_CHAR_CLASS_H
+
+namespace configparser
+{
+namespace detail
+{
+    enum class CharClass : unsigned char
+    {
+        CHAR_OTHER,
+        CHAR_IDENTIFIER_START, // letters, '.', '$', ':'
+        CHAR_IDENTIFIER, // digits, '_', '~', '-'
+        CHAR_SPACE,
+        CHAR_BLANK, // '\t', '\r'
+        CHAR_NEWLINE,
+        CHAR_COMMENT,
+        CHAR_SECTION,
+        CHAR_VALUE,
+        CHAR_ESCAPE,
+        CHAR_END,
+
+        CHAR_NUM
+    }; // CharClass
+
+    struct char_class_table
+    {
+        CharClass classes[256];
+    }; // char_class_table
+
+    constexpr char_class_table make_char_class_table()
+    {
+        char_class_table table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            table.classes[c] = CharClass::CHAR_OTHER;
+        }
+
+        // ASCII letters only, unlike isalpha()
+        // this does not depend on the locale
+        for (int c = 'a'; c <= 'z'; ++c)
+        {
+            table.classes[c] = CharClass::CHAR_IDENTIFIER_START;
+            table.classes[c - 'a' + 'A'] = CharClass::CHAR_IDENTIFIER_START;
+        }
+
+        for (int c = '0'; c <= '9'; ++c)
+        {
+            table.classes[c] = CharClass::CHAR_IDENTIFIER;
+        }
+
+        table.classes[(unsigned char)'.'] = CharClass::CHAR_IDENTIFIER_START;
+        table.classes[(unsigned char)'$'] = CharClass::CHAR_IDENTIFIER_START;
+        table.classes[(unsigned char)':'] = CharClass::CHAR_IDENTIFIER_START;
+
+        table.classes[(unsigned char)'_'] = CharClass::CHAR_IDENTIFIER;
+        table.classes[(unsigned char)'~'] = CharClass::CHAR_IDENTIFIER;
+        table.classes[(unsigned char)'-'] = CharClass::CHAR_IDENTIFIER;
+
+        table.classes[(unsigned char)' '] = CharClass::CHAR_SPACE;
+        table.classes[(unsigned char)'\t'] = CharClass::CHAR_BLANK;
+        table.classes[(unsigned char)'\r'] = CharClass::CHAR_BLANK;
+        table.classes[(unsigned char)'\n'] = CharClass::CHAR_NEWLINE;
+        table.classes[(unsigned char)';'] = CharClass::CHAR_COMMENT;
+        table.classes[(unsigned char)'['] = CharClass::CHAR_SECTION;
+        table.classes[(unsigned char)'='] = CharClass::CHAR_VALUE;
+        table.classes[(unsigned char)'\\'] = CharClass::CHAR_ESCAPE;
+        table.classes[0] = CharClass::CHAR_END;
+
+        return table;
+    }
+
+    inline constexpr char_class_table char_classes = make_char_class_table();
+
+    constexpr CharClass char_class(char c)
+    {
+        return char_classes.classes[(unsigned char)c];
+    }
+
+    // identifiers may contain spaces, but not start with one;
+    // an escaped space ("\\ ") is handled by the tokenizer
+    constexpr bool is_identifier_class(CharClass c)
+    {
+        return (c == CharClass::CHAR_IDENTIFIER_START) ||
+            (c == CharClass::CHAR_IDENTIFIER) ||
+            (c == CharClass::CHAR_SPACE);
+    }
+} // detail
+} // configparser
+
+#endif // CP_CHAR_CLASS_H
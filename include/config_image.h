@@ -0,0 +1,272 @@
+#ifndef CP_CONFIG_IMAGE_H
+#define CP_CONFIG_IMAGE_H
+
+#include "configparser.h"
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace configparser
+{
+namespace detail
+{
+    // the image is written in native byte order and mapped as it
+    // is; every table starts 8 byte aligned, offsets are from the
+    // start of the image and indices are into the tables
+    struct image_header
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t size; // of the whole image
+        std::uint64_t checksum; // of everything after it
+        std::uint64_t source_hash;
+
+        std::uint64_t section_count;
+        std::uint64_t option_count;
+        std::uint64_t value_count;
+        std::uint64_t sections;
+        std::uint64_t options;
+        std::uint64_t values;
+
+        // open addressing tables of (index + 1) slots, the
+        // sections have one and every section one for its options
+        std::uint64_t slots;
+        std::uint64_t slot_count;
+        std::uint64_t section_slots;
+        std::uint64_t section_slot_count;
+    }; // image_header
+
+    struct image_section_entry
+    {
+        std::uint64_t name;
+        std::uint64_t name_size;
+        std::uint64_t name_hash;
+        std::uint64_t first_option;
+        std::uint64_t option_count;
+        std::uint64_t option_slots;
+        std::uint64_t option_slot_count;
+    }; // image_section_entry
+
+    struct image_option_entry
+    {
+        std::uint64_t name;
+        std::uint64_t name_size;
+        std::uint64_t name_hash;
+        std::uint64_t first_value;
+        std::uint64_t value_count;
+    }; // image_option_entry
+
+    struct image_value_entry
+    {
+        std::uint32_t type; // ValueType
+        std::uint32_t size; // of a string
+        union
+        {
+            std::int64_t l;
+            double d;
+            std::uint64_t b;
+            std::uint64_t str; // offset of a NUL terminated string
+        };
+    }; // image_value_entry
+
+    // a view over consecutive entries of one of the tables
+    template <typename View>
+    class image_range
+    {
+    public:
+        using entry_type = typename View::entry_type;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = View;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = View;
+
+            iterator(const char* base, const entry_type* entry) : m_base(base), m_entry(entry) {}
+
+            View operator*() const { return View(m_base, m_entry); }
+            iterator& operator++() { ++m_entry; return *this; }
+            iterator operator++(int) { iterator it = *this; ++m_entry; return it; }
+            bool operator==(const iterator& other) const { return m_entry == other.m_entry; }
+            bool operator!=(const iterator& other) const { return m_entry != other.m_entry; }
+
+        private:
+            const char* m_base;
+            const entry_type* m_entry;
+        }; // iterator
+
+        image_range(const char* base, const entry_type* entries, std::size_t count)
+            : m_base(base), m_entries(entries), m_count(count)
+        {}
+
+        iterator begin() const { return iterator(m_base, m_entries); }
+        iterator end() const { return iterator(m_base, m_entries + m_count); }
+        std::size_t size() const { return m_count; }
+        bool empty() const { return m_count == 0; }
+        View operator[](std::size_t idx) const { return View(m_base, m_entries + idx); }
+
+    private:
+        const char* m_base;
+        const entry_type* m_entries;
+        std::size_t m_count;
+    }; // image_range
+} // detail
+
+    // the views below point into an open config_image and
+    // are only valid as long as it stays open
+
+    class image_value
+    {
+    public:
+        using entry_type = detail::image_value_entry;
+
+        image_value(const char* base, const entry_type* entry) : m_base(base), m_entry(entry) {}
+
+        ValueType type() const;
+        bool has_type(ValueType type) const;
+
+        // like value_type, only valid for the type of the value
+        long to_long() const;
+        double to_double() const;
+        bool to_bool() const;
+        std::string_view to_view() const;
+
+    private:
+        const char* m_base;
+        const entry_type* m_entry;
+    }; // image_value
+
+    class image_option
+    {
+    public:
+        using entry_type = detail::image_option_entry;
+
+        image_option(const char* base, const entry_type* entry) : m_base(base), m_entry(entry) {}
+
+        template <typename ValueType>
+        ValueType get() const;
+        template <typename ValueType>
+        ValueType get(size_t idx) const;
+        template <typename ValueType>
+        bool get(size_t idx, ValueType& val) const;
+
+        ValueType get_type() const;
+        ValueType get_type(size_t idx) const;
+
+        size_t size() const;
+        bool is_vector() const;
+
+        detail::image_range<image_value> values() const;
+        std::string_view name() const;
+
+    private:
+        const char* m_base;
+        const entry_type* m_entry;
+    }; // image_option
+
+    template <typename ValueType>
+    ValueType image_option::get() const
+    {
+        return get<ValueType>(0);
+    }
+
+    class image_section
+    {
+    public:
+        using entry_type = detail::image_section_entry;
+
+        image_section(const char* base, const entry_type* entry) : m_base(base), m_entry(entry) {}
+
+        detail::image_range<image_option> options() const;
+        // throws std::out_of_range for a missing option
+        image_option option(std::string_view option_name) const;
+        std::optional<image_option> find_option(std::string_view option_name) const noexcept;
+        std::optional<image_option> find_option(std::string_view option_name, std::uint64_t hash) const noexcept;
+
+        bool has_option(std::string_view option_name) const noexcept;
+
+        std::string_view name() const;
+
+    private:
+        const char* m_base;
+        const entry_type* m_entry;
+    }; // image_section
+
+    // a parsed document compiled into a flat binary image, which is
+    // mapped and queried in place: opening it costs a mapping and a
+    // few checks instead of a parse, lookups go through hash tables
+    // stored in the image; the image holds typed values, links are
+    // resolved already, and the hash of the text it was compiled
+    // from, to tell whether that text changed since
+    class config_image
+    {
+    public:
+        static constexpr std::uint32_t VERSION = 2;
+
+        config_image() = default;
+        config_image(const config_image&) = delete;
+        config_image(config_image&&) noexcept = default;
+        config_image& operator=(const config_image&) = delete;
+        config_image& operator=(config_image&&) noexcept = default;
+        ~config_image() = default;
+
+        // false for anything but a complete image of this version
+        // and byte order; every entry is checked to point within the
+        // image, and without verify_checksum that is all, which skips
+        // hashing the whole image but trusts the names and values
+        bool open(const char* filename, bool verify_checksum = true);
+        void close();
+        bool is_open() const;
+
+        detail::image_range<image_section> sections() const;
+        // throws std::out_of_range for a missing section or option
+        image_section get_section(std::string_view section_name) const;
+        image_option option(std::string_view section_name, std::string_view option_name) const;
+        // a duplicate name finds its first section, like ConfigParser
+        std::optional<image_section> find_section(std::string_view section_name) const noexcept;
+        std::optional<image_option> find_option(std::string_view section_name, std::string_view option_name) const noexcept;
+        std::optional<image_option> find_option(const option_key& key) const noexcept;
+
+        bool has_section(std::string_view section_name) const noexcept;
+        bool has_option(std::string_view section_name, std::string_view option_name) const noexcept;
+
+        std::uint64_t source_hash() const;
+        // whether the text at source_filename is not the one
+        // the image was compiled from, or cannot be read
+        bool is_stale(const char* source_filename) const;
+
+        // of a text, as stored in an image compiled from it
+        static std::uint64_t hash_source(std::string_view text);
+
+        // writes the parsed document as an image; the file is
+        // replaced at once, so readers never map half an image
+        static bool write(const ConfigParser& parser, const char* filename, std::uint64_t source_hash = 0);
+        // parses source_filename as a parser with the settings of
+        // settings would and writes its image, false if either fails
+        static bool compile(const char* source_filename, const char* filename,
+            const ConfigParser& settings = ConfigParser());
+
+    private:
+        std::optional<image_section> find_section(std::string_view section_name, std::uint64_t hash) const noexcept;
+        bool check(bool verify_checksum) const;
+        const detail::image_header& header() const;
+
+        // the image is read into the buffer where it cannot be mapped
+        detail::mapped_file m_file;
+        std::vector<std::uint64_t> m_buffer;
+        const char* m_data = nullptr;
+        std::size_t m_size = 0;
+    }; // config_image
+
+} // configparser
+
+#endif // CP_CONFIG_IMAGE_H
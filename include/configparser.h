@@ -3,47 +3,348 @@
 
 #include "error_code.h"
 #include "section_type.h"
+#include "option_key.h"
 #include "token.h"
+#include "string_pool.h"
+#include "string_interner.h"
+#include "value_parser.h"
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
 
 namespace configparser
 {
 
+    enum class LoadMode
+    {
+        LOAD_STREAM, // read the whole file into memory
+        LOAD_MMAP, // map the file, fall back to LOAD_STREAM when not possible
+
+        LOAD_NUM
+    }; // LoadMode
+
+    enum class DocumentMode
+    {
+        DOCUMENT_COPY, // string values are copied into the values
+        DOCUMENT_VIEW, // string values borrow from the parsed text
+
+        DOCUMENT_NUM
+    }; // DocumentMode
+
+    enum class MemoryMode
+    {
+        MEMORY_HEAP, // every object is allocated on its own
+        MEMORY_ARENA, // every parse allocates from its own arena
+
+        MEMORY_NUM
+    }; // MemoryMode
+
+    enum class ValueMode
+    {
+        VALUE_EAGER, // values are typed while parsing
+        VALUE_LAZY, // values are typed on first access
+
+        VALUE_NUM
+    }; // ValueMode
+
+    enum class NumberMode
+    {
+        NUMBER_LENIENT, // a number out of range is kept as a string
+        NUMBER_STRICT, // a number out of range fails the parse
+
+        NUMBER_NUM
+    }; // NumberMode
+
+    class config_reloader;
+    class config_image;
+    struct batch_input;
+    struct batch_result;
+
+    enum class InternMode
+    {
+        INTERN_NONE, // every name and string value is stored on its own
+        INTERN_NAMES, // equal section and option names are stored once
+        INTERN_ALL, // equal names and string values are stored once
+
+        INTERN_NUM
+    }; // InternMode
+
     class ConfigParser
     {
     public:
-        ConfigParser() = default;
+        ConfigParser();
         ConfigParser(const ConfigParser&) = default;
-        ConfigParser(ConfigParser&&) noexcept = default;
-        ConfigParser& operator=(const ConfigParser&) = default;
-        ConfigParser& operator=(ConfigParser&&) noexcept = default;
+        // a moved from parser has no document, it can
+        // only be parsed into, assigned to or destroyed
+        ConfigParser(ConfigParser&& other) noexcept;
+        ConfigParser& operator=(const ConfigParser& other);
+        ConfigParser& operator=(ConfigParser&& other) noexcept;
         ~ConfigParser() = default;
 
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+        // in DocumentMode::DOCUMENT_VIEW the parsed text is kept
+        // alive by the parser and names and string values are
+        // views into it; only values with escapes are copied
+        void set_document_mode(DocumentMode mode);
+        DocumentMode document_mode() const;
+
+        // in MemoryMode::MEMORY_ARENA sections, options, values, hash
+        // nodes and pooled strings of a parse come from a monotonic
+        // arena, released at once by the next parse or destruction;
+        // the resource (default heap when null) is used for everything
+        // in MEMORY_HEAP mode and feeds the arena in MEMORY_ARENA mode,
+        // it must outlive the parser; both apply from the next parse
+        void set_memory_mode(MemoryMode mode);
+        MemoryMode memory_mode() const;
+        void set_memory_resource(std::pmr::memory_resource* resource);
+        std::pmr::memory_resource* memory_resource() const;
+
+        // in ValueMode::VALUE_LAZY only links are resolved while
+        // parsing, other values keep their raw text (owned by the
+        // parser) and are typed and cached on first access, which
+        // is safe for concurrent readers; applies from the next parse
+        void set_value_mode(ValueMode mode);
+        ValueMode value_mode() const;
+
+        // in NumberMode::NUMBER_STRICT an integer that does not fit a
+        // long, or a floating point number out of the range of a double,
+        // fails the parse with ErrorCode::NUMBER_OUT_OF_RANGE instead
+        // of becoming a string; lazy values are checked while parsing
+        // as well, still typed on first access; applies from the next
+        // parse
+        void set_number_mode(NumberMode mode);
+        NumberMode number_mode() const;
+
+        // extra words typed as booleans, e.g. "ja" or "nein", on top
+        // of y/t/n/f and on/yes/enabled/off/no/disabled; they belong to
+        // the parser, are shared by its copies and apply from the next
+        // parse; the list can be handed to other parsers as a whole
+        void add_boolean_word(std::string_view word, bool value);
+        void clear_boolean_words();
+        void set_boolean_words(std::shared_ptr<const detail::boolean_words> words);
+        const std::shared_ptr<const detail::boolean_words>& boolean_words() const;
+
+        // with interning, names are views into a string_interner and
+        // (with InternMode::INTERN_ALL) string values and the raw text
+        // of lazy values share its strings, which saves memory for
+        // repetitive documents and makes equal names compare by
+        // address; the interner is created for every parse unless
+        // one is set, which is then shared by all documents using it
+        // and may be used from several threads; both apply from the
+        // next parse
+        void set_intern_mode(InternMode mode);
+        InternMode intern_mode() const;
+        void set_interner(std::shared_ptr<string_interner> interner);
+        const std::shared_ptr<string_interner>& interner() const;
+
+        // with more than one thread (0 for all hardware threads) large
+        // texts are split at section headers and the parts are parsed
+        // in parallel; links are resolved once the whole document is
+        // parsed, so they may point to options defined further down,
+        // and chains independent of each other are resolved in
+        // parallel as well; both only apply to documents using the
+        // default heap, the result is the same as with one thread;
+        // defaults to 1
+        void set_thread_count(unsigned count);
+        unsigned thread_count() const;
+
         bool parse_text(const char* text);
-        bool parse_file(const char* filename);
+        bool parse_text(std::string&& text);
+        bool parse_file(const char* filename, LoadMode mode = LoadMode::LOAD_MMAP);
+
+        // bounded memory parsing, the input is read in chunks
+        // and only the last incomplete line is kept between them
+        bool parse_stream(std::istream& stream, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+        bool parse_fd(int fd, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+        // parses a new version of the text parsed by the previous
+        // reparse call: sections whose text did not change are kept
+        // as they are, only changed ones and the ones linking into
+        // them are parsed again; names and values of parsed sections
+        // are always copied, and the strings (in MEMORY_ARENA all the
+        // memory) of replaced sections are only released by a full
+        // parse, which is done once more text was replaced than is
+        // still in use; without a successful previous reparse, or
+        // once the parser was copied, the whole text is parsed
+        bool reparse_text(const char* text);
+        bool reparse_file(const char* filename);
+
+        // push style parsing, e.g. for data arriving over a pipe;
+        // feed() returns false once the input is known to be invalid
+        void feed_begin();
+        bool feed(const char* data, size_t size);
+        bool feed_end();
 
         ErrorCode error_code() const;
         int get_error_line() const;
         int get_error_column() const;
 
+        // builds a minimal perfect hash over the section and option
+        // names of the parsed document for faster lookups; call it
+        // once parsing is done, the next parse drops it again, while
+        // a reparse of a frozen document freezes the new one as well
+        void freeze();
+        bool is_frozen() const noexcept;
+
         const section_vector& sections() const;
-        const option_vector& options(const std::string& section_name) const;
-        const option_type& option(const std::string& section_name, const std::string& option_name) const;
+        // these throw std::out_of_range for missing names
+        const option_vector& options(std::string_view section_name) const;
+        const option_type& option(std::string_view section_name, std::string_view option_name) const;
+
+        // these return nullptr for missing names
+        const section_type* find_section(std::string_view section_name) const noexcept;
+        const option_type* find_option(std::string_view section_name, std::string_view option_name) const noexcept;
+
+        bool has_section(std::string_view section_name) const noexcept;
+        bool has_option(std::string_view section_name, std::string_view option_name) const noexcept;
 
-        bool has_section(const std::string& section_name) const;
-        bool has_option(const std::string& section_name, const std::string& option_name) const;
+        // resolves an option once for repeated access, an unknown option
+        // gives a handle that is never valid; with a frozen parser an
+        // option_key is looked up without hashing the names again
+        option_handle resolve(std::string_view section_name, std::string_view option_name) const noexcept;
+        option_handle resolve(const option_key& key) const noexcept;
+        bool is_valid(const option_handle& handle) const noexcept;
+
+        // the handle must be valid
+        const option_type& option(const option_handle& handle) const;
+        // nullptr for a stale handle or a missing option
+        const option_type* find_option(const option_handle& handle) const noexcept;
+        const option_type* find_option(const option_key& key) const noexcept;
+
+    private:
+        // the settings of other, but not its document; whatever parses
+        // with the settings of another parser goes through it
+        void copy_settings(const ConfigParser& other);
+
+        friend class config_reloader;
+        friend class config_image;
+        friend std::vector<batch_result> parse_batch(const std::vector<batch_input>& inputs,
+            const ConfigParser& settings, unsigned thread_count);
 
     public:
-        using section_map = std::unordered_map<std::string, size_t>;
+        using section_map = detail::key_map;
+
+        enum class ParseState
+        {
+            STATE_EXPECT_SECTION,
+            STATE_SECTION,
+            STATE_EXPECT_VALUE,
+            STATE_VECTOR_VALUE,
+            STATE_ERROR,
+
+            STATE_NUM
+        }; // ParseState
+
+        class parser_sink;
+
+        bool parse_stream_file(const char* filename);
+        bool parse_buffer(const char* text);
+        bool parse_parallel(const char* text, size_t size);
+        bool reparse_buffer(const char* text);
+        bool reparse_chunks(const char* text);
+        void parse_begin();
+        bool parse_token(const detail::token& t);
+        bool parse_end();
+        bool tokenize(const char* text, int& line, int& column, const char* end = nullptr);
+        bool parse_value(option_type& option, const detail::token& t);
+        bool is_parallel() const;
+        bool has_pending_links(size_t section_idx, size_t option_idx) const;
+        bool resolve_links();
+        void make_columns();
+        std::string_view store_string(std::string_view str);
+        std::string_view store_name(std::string_view str);
+
+        bool feed_lines(size_t appended, bool last);
+        void set_error(ErrorCode error_code, int line, int column);
+        bool read_failed();
+
+        void release_document() noexcept;
+        void reset_document();
+        const section_type& get_section(std::string_view section_name) const;
+        size_t find_section_index(std::string_view section_name) const noexcept;
+        size_t find_section_index(std::string_view section_name, std::uint64_t hash) const noexcept;
+
+        MemoryMode m_memory_mode = MemoryMode::MEMORY_HEAP;
+        std::pmr::memory_resource* m_memory_resource = nullptr;
+
+        // declared before the containers allocating
+        // from it, so that it is destroyed after them
+        std::shared_ptr<std::pmr::memory_resource> m_arena;
+
+        // containers are rebuilt for every parse, as their
+        // memory resource cannot be changed afterwards
+        std::optional<section_vector> m_sections;
+        std::optional<section_map> m_sections_map;
+        std::optional<detail::perfect_hash> m_sections_index;
+
+        // names (and borrowed values) point either into the
+        // kept text or into the string pool; both are shared
+        // between copies of the parser and never modified
+        ValueMode m_value_mode = ValueMode::VALUE_EAGER;
+        NumberMode m_number_mode = NumberMode::NUMBER_LENIENT;
+        std::shared_ptr<const detail::boolean_words> m_boolean_words; // null without extra words
+        DocumentMode m_document_mode = DocumentMode::DOCUMENT_COPY;
+        std::shared_ptr<const void> m_text_owner;
+        std::shared_ptr<detail::string_pool> m_strings;
+        bool m_borrow_text = false;
+
+        // the interner of the document, shared between
+        // copies of the parser; null without interning
+        InternMode m_intern_mode = InternMode::INTERN_NONE;
+        std::shared_ptr<string_interner> m_shared_interner;
+        std::shared_ptr<string_interner> m_interner;
+
+        // changes with every parse, handles from
+        // another generation are stale
+        std::uint64_t m_generation = 0;
+
+        // a link that could not be resolved while parsing,
+        // its text stays in the values until it is resolved
+        struct pending_link
+        {
+            size_t section_idx;
+            size_t option_idx;
+            size_t value_idx;
+            std::string_view section_name;
+            std::string_view option_name;
+            int line;
+            int column;
+        }; // pending_link
+
+        std::vector<pending_link> m_links;
+        bool m_defer_links = false;
+
+        // what a reparse compares a chunk of the text against, a
+        // chunk starts at a line starting with a section header
+        struct chunk_record
+        {
+            std::uint64_t hash;
+            size_t size;
+            size_t sections;
+            std::vector<std::string_view> links; // section names
+        }; // chunk_record
+
+        // valid while the document comes from a reparse
+        std::vector<chunk_record> m_records;
+        bool m_incremental = false;
+        size_t m_dead_bytes = 0; // of replaced chunks, still in memory
+        unsigned m_thread_count = 1;
 
-        bool parse_tokens(const std::vector<detail::token>& tokens);
-        void parse_value(values_vector& values, const detail::token& t);
+        ParseState m_parse_state = ParseState::STATE_EXPECT_SECTION;
+        int m_identifier_line = 0;
+        int m_identifier_column = 0;
 
-        section_vector m_sections;
-        section_map m_sections_map;
+        std::string m_feed_buffer;
+        int m_feed_line = 1;
+        int m_feed_column = 1;
+        bool m_feed_stopped = false;
 
-        ErrorCode m_error_code;
-        int m_error_line;
-        int m_error_column;
+        ErrorCode m_error_code = ErrorCode::NO_ERROR;
+        int m_error_line = 0;
+        int m_error_column = 0;
     }; // ConfigParser
 
 } // configparser
@@ -16,6 +16,15 @@ namespace configparser
         EXPECTING_VALUE_AFTER_IDENTIFIER,
         UNEXPECTED_VALUE,
         UNEXPECTED_TOKEN,
+
+        // link error codes
+        LINK_CYCLE,
+
+        // value error codes
+        NUMBER_OUT_OF_RANGE, // only with NumberMode::NUMBER_STRICT
+
+        // input error codes, without a line and column
+        READ_ERROR, // the file could not be opened or read
     }; // ErrorCode
 }
 
@@ -0,0 +1,40 @@
+#ifndef CP_MAPPED_FILE_H
+#define CP_MAPPED_FILE_H
+
+#include <cstddef>
+
+namespace configparser
+{
+namespace detail
+{
+    // read-only memory mapping of a whole file; the mapped
+    // text is always followed by a NUL character, so it can be
+    // handed to the tokenizer without being copied first
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file(mapped_file&& other) noexcept;
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file& operator=(mapped_file&& other) noexcept;
+        ~mapped_file();
+
+        bool open(const char* filename);
+        void close();
+
+        bool is_open() const;
+
+        const char* data() const;
+        std::size_t size() const;
+
+    private:
+        void* m_address = nullptr;
+        std::size_t m_mapped_length = 0;
+        std::size_t m_size = 0;
+        bool m_open = false;
+    }; // mapped_file
+} // detail
+} // configparser
+
+#endif // CP_MAPPED_FILE_H
@@ -0,0 +1,61 @@
+#ifndef CP_OPTION_KEY_H
+#define CP_OPTION_KEY_H
+
+#include "perfect_hash.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace configparser
+{
+
+    // (section, option) name pair hashed at compile time, e.g.:
+    // static constexpr option_key SERVER_PORT{ "Server", "port" };
+    // the names must outlive the key, like string literals do
+    class option_key
+    {
+    public:
+        constexpr option_key(std::string_view section_name, std::string_view option_name)
+            : m_section_name(section_name)
+            , m_option_name(option_name)
+            , m_section_hash(detail::hash_key(section_name))
+            , m_option_hash(detail::hash_key(option_name))
+        {}
+
+        constexpr std::string_view section_name() const { return m_section_name; }
+        constexpr std::string_view option_name() const { return m_option_name; }
+        constexpr std::uint64_t section_hash() const { return m_section_hash; }
+        constexpr std::uint64_t option_hash() const { return m_option_hash; }
+
+    private:
+        std::string_view m_section_name;
+        std::string_view m_option_name;
+        std::uint64_t m_section_hash;
+        std::uint64_t m_option_hash;
+    }; // option_key
+
+    // option resolved once by ConfigParser::resolve(); using it is a
+    // direct index into the parsed document, and it goes stale once
+    // the parser it came from starts another parse
+    class option_handle
+    {
+    public:
+        constexpr option_handle() = default;
+
+    private:
+        constexpr option_handle(std::size_t section_idx, std::size_t option_idx, std::uint64_t generation)
+            : m_section_idx(section_idx)
+            , m_option_idx(option_idx)
+            , m_generation(generation)
+        {}
+
+        std::size_t m_section_idx = 0;
+        std::size_t m_option_idx = 0;
+        std::uint64_t m_generation = 0; // 0 never resolved anything
+
+        friend class ConfigParser;
+    }; // option_handle
+
+} // configparser
+
+#endif // CP_OPTION_KEY_H
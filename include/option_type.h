@@ -2,6 +2,9 @@
 #define CP_OPTION_TYPE_H
 
 #include "value_type.h"
+#include "value_column.h"
+#include <memory>
+#include <vector>
 
 namespace configparser
 {
@@ -9,10 +12,15 @@ namespace configparser
     class option_type
     {
     public:
-        option_type(std::string&& name) noexcept;
-        option_type(const option_type&) = default;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+        option_type(std::string_view name) noexcept;
+        option_type(std::string_view name, const allocator_type& alloc) noexcept;
+        option_type(const option_type& other);
+        option_type(const option_type& other, const allocator_type& alloc);
         option_type(option_type&&) noexcept = default;
-        option_type& operator=(const option_type&) = default;
+        option_type(option_type&& other, const allocator_type& alloc);
+        option_type& operator=(const option_type& other);
         option_type& operator=(option_type&&) noexcept = default;
         ~option_type() = default;
 
@@ -29,8 +37,12 @@ namespace configparser
         double get_double(size_t idx) const;
         bool get_bool() const;
         bool get_bool(size_t idx) const;
+        // these throw std::logic_error for strings borrowed from the
+        // text (DocumentMode::DOCUMENT_VIEW), get_view() works for all
         const std::string& get_str() const;
         const std::string& get_str(size_t idx) const;
+        std::string_view get_view() const;
+        std::string_view get_view(size_t idx) const;
 
         ValueType get_type() const;
         ValueType get_type(size_t idx) const;
@@ -41,12 +53,55 @@ namespace configparser
         size_t size() const;
         bool is_vector() const;
 
+        // a list whose values all are longs, doubles or booleans is
+        // stored as one column once parsed (in ValueMode::VALUE_EAGER),
+        // read here without a type check per value; the spans are
+        // empty for other options, and values() then builds the
+        // tagged values on first use
+        bool is_column() const;
+        template <typename ValueType>
+        span<const ValueType> get_column() const;
+        // bit (i % 64) of word (i / 64) is value i
+        span<const std::uint64_t> get_column_bits() const;
+
+        // copies the values from first on into out, as many as fit,
+        // instead of one get() per value: a column is copied at once;
+        // a value of another type is skipped, leaving its element of
+        // out as it is, and its index is added to failed when given;
+        // returns the number of values copied
+        template <typename ValueType>
+        size_t extract(span<ValueType> out, std::vector<size_t>* failed = nullptr, size_t first = 0) const;
+
         const values_vector& values() const;
-        const std::string& name() const;
+        std::string_view name() const;
 
     private:
-        std::string m_name;
+        values_vector& own_values();
+        std::shared_ptr<const values_vector> share_values();
+        // stores a list of one type as a column, and back
+        void make_column();
+        void drop_column();
+        // appends the values of a linked option, sharing
+        // them when this option has no values yet
+        void link_values(option_type& source);
+
+        struct value_link
+        {
+            size_t position; // of the value holding the link text
+            option_type* source;
+        }; // value_link
+
+        // replaces the values holding link texts with the values
+        // of the linked options, positions must be ascending
+        void splice_links(const value_link* links, size_t count);
+
+        std::string_view m_name;
         values_vector m_values;
+        // values shared with the options linking to them,
+        // used instead of m_values when set
+        std::shared_ptr<const values_vector> m_shared_values;
+        // used instead of both when set
+        std::shared_ptr<const detail::value_column> m_column;
 
         friend class ConfigParser;
     }; // option_type
@@ -57,7 +112,7 @@ namespace configparser
         return get<ValueType>(0);
     }
 
-    using option_vector = std::vector<option_type>;
+    using option_vector = std::pmr::vector<option_type>;
 
 } // configparser
 
@@ -0,0 +1,71 @@
+#ifndef CP_PARALLEL_H
+#define CP_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace configparser
+{
+namespace detail
+{
+    // 0 stands for the number of hardware threads
+    unsigned effective_thread_count(unsigned thread_count);
+
+    // fixed set of threads running batches of indexed tasks; every
+    // thread has its own queue and steals from the others once it
+    // runs dry, so uneven tasks still keep all threads busy
+    class thread_pool
+    {
+    public:
+        // the calling thread of run() counts as one of them
+        explicit thread_pool(unsigned thread_count);
+        thread_pool(const thread_pool&) = delete;
+        thread_pool(thread_pool&&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        thread_pool& operator=(thread_pool&&) = delete;
+        ~thread_pool();
+
+        size_t size() const noexcept;
+
+        // calls task(i) for every i in [0, count) and returns once all
+        // are done, rethrowing the first exception thrown by a task;
+        // tasks are started about in index order, so the most
+        // expensive ones should come first
+        void run(size_t count, const std::function<void(size_t)>& task);
+
+    private:
+        struct queue
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        }; // queue
+
+        bool pop(size_t self, size_t& task);
+        void work(size_t self);
+        void worker_main(size_t self);
+
+        std::vector<std::unique_ptr<queue>> m_queues; // the caller has the first
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_run_mutex; // one batch at a time
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        const std::function<void(size_t)>* m_task = nullptr;
+        std::atomic<size_t> m_pending{ 0 };
+        std::exception_ptr m_error;
+        size_t m_batch = 0;
+        bool m_stop = false;
+    }; // thread_pool
+} // detail
+} // configparser
+
+#endif // CP_PARALLEL_H
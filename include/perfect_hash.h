@@ -0,0 +1,117 @@
+#ifndef CP_PERFECT_HASH_H
+#define CP_PERFECT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace configparser
+{
+namespace detail
+{
+    constexpr std::uint64_t mix_hash(std::uint64_t x)
+    {
+        x ^= x >> 32;
+        x *= 0xD6E8FEB86659FD93ull;
+        x ^= x >> 32;
+        x *= 0xD6E8FEB86659FD93ull;
+        x ^= x >> 32;
+
+        return x;
+    }
+
+    constexpr std::uint64_t load_word(const char* ptr, std::size_t size)
+    {
+        std::uint64_t word = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            word |= (std::uint64_t)(unsigned char)ptr[i] << (8 * i);
+        }
+
+        return word;
+    }
+
+    // hashes 8 bytes at a time, usable at compile time;
+    // full words are written out so they compile to one load
+    constexpr std::uint64_t hash_key(std::string_view key)
+    {
+        std::uint64_t h = 0x9E3779B97F4A7C15ull ^ key.size();
+
+        const char* ptr = key.data();
+        std::size_t size = key.size();
+        while (size >= 8)
+        {
+            const std::uint64_t word =
+                (std::uint64_t)(unsigned char)ptr[0] |
+                ((std::uint64_t)(unsigned char)ptr[1] << 8) |
+                ((std::uint64_t)(unsigned char)ptr[2] << 16) |
+                ((std::uint64_t)(unsigned char)ptr[3] << 24) |
+                ((std::uint64_t)(unsigned char)ptr[4] << 32) |
+                ((std::uint64_t)(unsigned char)ptr[5] << 40) |
+                ((std::uint64_t)(unsigned char)ptr[6] << 48) |
+                ((std::uint64_t)(unsigned char)ptr[7] << 56);
+
+            h = (h ^ word) * 0x9FB21C651E98DF25ull;
+            h ^= h >> 29;
+            ptr += 8;
+            size -= 8;
+        }
+
+        return mix_hash(h ^ load_word(ptr, size));
+    }
+
+    using key_map = std::pmr::unordered_map<std::string_view, std::size_t>;
+
+    // minimal perfect hash (hash and displace) over a fixed set
+    // of keys; every key has its own slot in one contiguous table,
+    // and keys outside the set are rejected by the stored key
+    class perfect_hash
+    {
+    public:
+        struct entry
+        {
+            std::uint64_t hash;
+            std::string_view key;
+            std::size_t value;
+        }; // entry
+
+        using allocator_type = std::pmr::polymorphic_allocator<entry>;
+
+        static constexpr std::size_t npos = (std::size_t)-1;
+
+        perfect_hash() = default;
+        explicit perfect_hash(const allocator_type& alloc);
+        perfect_hash(const perfect_hash&) = default;
+        perfect_hash(const perfect_hash& other, const allocator_type& alloc);
+        perfect_hash(perfect_hash&&) noexcept = default;
+        perfect_hash(perfect_hash&& other, const allocator_type& alloc);
+        perfect_hash& operator=(const perfect_hash&) = default;
+        perfect_hash& operator=(perfect_hash&&) noexcept = default;
+        ~perfect_hash() = default;
+
+        // the keys must outlive the index; returns false, leaving
+        // the index empty, if no perfect hash could be found
+        bool build(const key_map& keys);
+        void clear();
+
+        bool is_built() const noexcept;
+        std::size_t size() const noexcept;
+
+        std::size_t find(std::string_view key) const noexcept;
+        std::size_t find(std::string_view key, std::uint64_t hash) const noexcept;
+
+    private:
+        static std::uint32_t reduce(std::uint64_t hash, std::size_t size) noexcept;
+        static std::size_t slot(std::uint64_t hash, std::uint32_t displacement, std::size_t size) noexcept;
+
+        std::pmr::vector<entry> m_entries;
+        std::pmr::vector<std::uint32_t> m_displacements;
+        bool m_built = false;
+    }; // perfect_hash
+} // detail
+} // configparser
+
+#endif // CP_PERFECT_HASH_H
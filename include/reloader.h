@@ -0,0 +1,112 @@
+#ifndef CP_RELOADER_H
+#define CP_RELOADER_H
+
+#include "configparser.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace configparser
+{
+
+    // a parsed version of a file, never modified once published
+    using config_snapshot = std::shared_ptr<const ConfigParser>;
+
+    // keeps the latest version of a file that parsed successfully;
+    // new versions are parsed aside, by reload() or by a thread
+    // watching the file, and published with an atomic swap, so
+    // readers never wait for a parse and never see a partial one
+    class config_reloader
+    {
+    public:
+        // takes the settings (but not the document) of settings;
+        // nothing is read until reload() or start() is called
+        explicit config_reloader(std::string path, const ConfigParser& settings = ConfigParser());
+        config_reloader(const config_reloader&) = delete;
+        config_reloader(config_reloader&&) = delete;
+        config_reloader& operator=(const config_reloader&) = delete;
+        config_reloader& operator=(config_reloader&&) = delete;
+        ~config_reloader();
+
+        // parses the file now; on failure the current
+        // snapshot stays and the error is kept
+        bool reload();
+
+        // reloads the file from a thread of its own whenever it is
+        // written or replaced (e.g. renamed over by an editor),
+        // starting with the current version of the file
+        bool start();
+        void stop();
+        bool is_watching() const;
+
+        // an empty document until a reload succeeds
+        config_snapshot snapshot() const;
+
+        // counts the published snapshots
+        std::uint64_t generation() const noexcept;
+
+        // of the last reload; waits for a running reload
+        ErrorCode error_code() const;
+        int get_error_line() const;
+        int get_error_column() const;
+
+        const std::string& path() const noexcept;
+
+    private:
+        void watch();
+
+        std::string m_path;
+        std::string m_file_name;
+
+        // only holds the settings, its document stays empty
+        ConfigParser m_settings;
+
+        // written under m_reload_mutex, read without locks
+        config_snapshot m_snapshot;
+        std::atomic<std::uint64_t> m_generation{ 0 };
+
+        // held for a whole reload, so versions are published in order
+        mutable std::mutex m_reload_mutex;
+        ErrorCode m_error_code = ErrorCode::NO_ERROR;
+        int m_error_line = 0;
+        int m_error_column = 0;
+
+        std::thread m_thread;
+        std::atomic<bool> m_stopping{ false };
+        std::mutex m_stop_mutex;
+        std::condition_variable m_stop_condition;
+        int m_watch_fd = -1; // inotify, where available
+        int m_stop_fds[2] = { -1, -1 };
+    }; // config_reloader
+
+    // one per reading thread: keeps the snapshot it last saw, so
+    // current() costs a single atomic load until a reload happens
+    class snapshot_reader
+    {
+    public:
+        explicit snapshot_reader(const config_reloader& reloader);
+        snapshot_reader(const snapshot_reader&) = default;
+        snapshot_reader(snapshot_reader&&) noexcept = default;
+        snapshot_reader& operator=(const snapshot_reader&) = delete;
+        snapshot_reader& operator=(snapshot_reader&&) = delete;
+        ~snapshot_reader() = default;
+
+        // the latest snapshot, valid until the next call
+        const ConfigParser& current();
+        const config_snapshot& snapshot();
+
+    private:
+        void refresh(std::uint64_t generation);
+
+        const config_reloader& m_reloader;
+        config_snapshot m_snapshot;
+        std::uint64_t m_generation = 0;
+    }; // snapshot_reader
+
+} // configparser
+
+#endif // CP_RELOADER_H
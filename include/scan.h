@@ -0,0 +1,39 @@
+#ifndef CP_SCAN_H
+#define CP_SCAN_H
+
+namespace configparser
+{
+namespace detail
+{
+    enum class ScanLevel
+    {
+        SCAN_SCALAR,
+        SCAN_SSE2,
+        SCAN_AVX2,
+
+        SCAN_NUM
+    }; // ScanLevel
+
+    // the best level supported by the running cpu is selected
+    // on first use; a lower one can be forced, e.g. for benchmarks
+    ScanLevel scan_level();
+    void set_scan_level(ScanLevel level);
+
+    // all scanners expect NUL terminated text and never look at
+    // text past the terminator, apart from reading whole aligned
+    // blocks that can not cross a page boundary
+
+    // first '\n' or NUL
+    const char* scan_line_end(const char* text);
+
+    // first '\n', ';' or NUL, reports whether a ',' or
+    // a ':' was found before it
+    const char* scan_value_end(const char* text, bool& has_comma, bool& has_colon);
+
+    // first character not allowed in an identifier, or a '\\',
+    // which has to be checked for an escaped space
+    const char* scan_identifier_end(const char* text);
+} // detail
+} // configparser
+
+#endif // CP_SCAN_H
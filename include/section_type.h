@@ -2,6 +2,8 @@
 #define CP_SECTION_TYPE_H
 
 #include "option_type.h"
+#include "perfect_hash.h"
+#include <deque>
 #include <unordered_map>
 
 namespace configparser
@@ -10,31 +12,45 @@ namespace configparser
     class section_type
     {
     public:
-        section_type(std::string&& name) noexcept;
+        using allocator_type = std::pmr::polymorphic_allocator<option_type>;
+
+        section_type(std::string_view name) noexcept;
+        section_type(std::string_view name, const allocator_type& alloc) noexcept;
         section_type(const section_type&) = default;
+        section_type(const section_type& other, const allocator_type& alloc);
         section_type(section_type&&) noexcept = default;
+        section_type(section_type&& other, const allocator_type& alloc);
         section_type& operator=(const section_type&) = default;
         section_type& operator=(section_type&&) noexcept = default;
         ~section_type() = default;
 
         const option_vector& options() const;
-        const option_type& option(const std::string& option_name) const;
+        // throws std::out_of_range for a missing option
+        const option_type& option(std::string_view option_name) const;
+        // nullptr for a missing option
+        const option_type* find_option(std::string_view option_name) const noexcept;
 
-        bool has_option(const std::string& option_name) const;
+        bool has_option(std::string_view option_name) const noexcept;
 
-        const std::string& name() const;
+        std::string_view name() const;
 
     private:
-        using option_map = std::unordered_map<std::string, size_t>;
+        using option_map = detail::key_map;
+
+        void freeze();
+        size_t find_index(std::string_view option_name) const noexcept;
+        size_t find_index(std::string_view option_name, std::uint64_t hash) const noexcept;
 
-        std::string m_name;
+        std::string_view m_name;
         option_vector m_options;
         option_map m_options_map;
+        detail::perfect_hash m_options_index;
 
         friend class ConfigParser;
     }; // section_type
 
-    using section_vector = std::vector<section_type>;
+    // sections never move once added
+    using section_vector = std::pmr::deque<section_type>;
 
 } // configparser
 
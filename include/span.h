@@ -0,0 +1,55 @@
+#ifndef CP_SPAN_H
+#define CP_SPAN_H
+
+#include <cstddef>
+#include <type_traits>
+
+#if (__cplusplus >= 202002L) && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define CP_HAS_STD_SPAN 1
+#endif
+#endif
+
+namespace configparser
+{
+
+#ifdef CP_HAS_STD_SPAN
+    template <typename T>
+    using span = std::span<T>;
+#else
+    // the part of std::span used by the library, until C++20
+    template <typename T>
+    class span
+    {
+    public:
+        using element_type = T;
+        using value_type = std::remove_cv_t<T>;
+        using size_type = std::size_t;
+        using pointer = T*;
+        using reference = T&;
+        using iterator = T*;
+
+        constexpr span() noexcept = default;
+        constexpr span(T* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+        constexpr T* data() const noexcept { return m_data; }
+        constexpr std::size_t size() const noexcept { return m_size; }
+        constexpr bool empty() const noexcept { return m_size == 0; }
+
+        constexpr T* begin() const noexcept { return m_data; }
+        constexpr T* end() const noexcept { return m_data + m_size; }
+
+        constexpr T& operator[](std::size_t idx) const { return m_data[idx]; }
+        constexpr T& front() const { return m_data[0]; }
+        constexpr T& back() const { return m_data[m_size - 1]; }
+
+    private:
+        T* m_data = nullptr;
+        std::size_t m_size = 0;
+    }; // span
+#endif
+
+} // configparser
+
+#endif // CP_SPAN_H
@@ -0,0 +1,72 @@
+#ifndef CP_STRING_INTERNER_H
+#define CP_STRING_INTERNER_H
+
+#include "value_type.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace configparser
+{
+
+    // stores every distinct string once, for names and string values
+    // repeated all over a document or across documents; equal strings
+    // interned by one interner are the same view, so comparing them
+    // takes a pointer comparison (see equal()); strings are only
+    // released with the interner, and it is safe to intern from
+    // multiple threads
+    class string_interner
+    {
+    public:
+        string_interner() = default;
+        string_interner(const string_interner&) = delete;
+        string_interner(string_interner&&) = delete;
+        string_interner& operator=(const string_interner&) = delete;
+        string_interner& operator=(string_interner&&) = delete;
+        ~string_interner();
+
+        // the stored copy of str, NUL terminated and
+        // valid as long as the interner is alive
+        std::string_view intern(std::string_view str);
+        // a string value sharing the stored copy of str,
+        // it stays valid after the interner is gone
+        value_type intern_value(std::string_view str);
+
+        // the number of distinct strings
+        std::size_t size() const;
+
+        // for views returned by the same interner
+        static bool equal(std::string_view a, std::string_view b) noexcept
+        {
+            return (a.data() == b.data()) && (a.size() == b.size());
+        }
+
+    private:
+        static constexpr std::size_t SHARD_COUNT = 16;
+
+        struct slot
+        {
+            std::uint64_t hash;
+            detail::shared_string* str; // null for a free slot
+        }; // slot
+
+        // open addressing table of the strings with the same top
+        // hash bits, so threads rarely wait for each other
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::vector<slot> slots;
+            std::size_t count = 0;
+        }; // shard
+
+        detail::shared_string* find_or_add(std::string_view str);
+        static void grow(shard& s);
+
+        shard m_shards[SHARD_COUNT];
+    }; // string_interner
+
+} // configparser
+
+#endif // CP_STRING_INTERNER_H
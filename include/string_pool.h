@@ -0,0 +1,58 @@
+#ifndef CP_STRING_POOL_H
+#define CP_STRING_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace configparser
+{
+namespace detail
+{
+    // append-only storage for strings; stored strings never
+    // move, so the returned views stay valid as long as the
+    // pool is alive and are followed by a NUL character
+    class string_pool
+    {
+    public:
+        explicit string_pool(
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+            std::shared_ptr<std::pmr::memory_resource> owner = nullptr);
+        string_pool(const string_pool&) = delete;
+        string_pool(string_pool&&) = delete;
+        string_pool& operator=(const string_pool&) = delete;
+        string_pool& operator=(string_pool&&) = delete;
+        ~string_pool();
+
+        std::string_view store(std::string_view str);
+        void clear();
+
+        // takes over the strings of another pool allocating
+        // from the same resource, their views stay valid
+        void adopt(string_pool& other);
+
+    private:
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        struct block
+        {
+            char* ptr;
+            std::size_t size;
+        }; // block
+
+        char* allocate(std::size_t size);
+
+        // keeps an arena alive while the strings are used
+        std::shared_ptr<std::pmr::memory_resource> m_owner;
+        std::pmr::memory_resource* m_resource;
+
+        std::vector<block> m_blocks;
+        char* m_block_ptr = nullptr;
+        std::size_t m_block_left = 0;
+    }; // string_pool
+} // detail
+} // configparser
+
+#endif // CP_STRING_POOL_H
@@ -28,6 +28,16 @@ namespace detail
         int column;
     }; // token
 
+    // receives the tokens as soon as they are found,
+    // instead of collecting them all first
+    class token_sink
+    {
+    public:
+        virtual ~token_sink() = default;
+
+        virtual void on_token(const token& t) = 0;
+    }; // token_sink
+
 } // detail
 } // tdetail
 
@@ -14,7 +14,10 @@ namespace detail
     public:
         tokenizer() = default;
 
-        ErrorCode parse(const char* text);
+        ErrorCode parse(const char* text, int line = 1, int column = 1);
+        ErrorCode parse(const char* text, token_sink& sink, int line = 1, int column = 1);
+        // stops at end, which must be the start of a line within text
+        ErrorCode parse(const char* text, const char* end, token_sink& sink, int line = 1, int column = 1);
 
         const std::vector<token>& tokens() const;
 
@@ -25,25 +28,29 @@ namespace detail
         char peek() const;
         char peekNext() const;
         void consume();
+        void advance(const char* ptr);
 
         bool eof() const;
         bool eol() const;
         bool empty() const;
 
-        static bool priority_value_separator(char val);
-        static bool value_separator(char val);
-
         void comment();
 
-        bool is_identifier_start();
-        bool is_identifier_char();
+        bool is_escaped_space() const;
+        bool is_identifier_char() const;
 
+        void identifier_chars();
         void identifier();
         void section();
         void value();
 
+        void emit(TokenType type, const char* begin_ptr, std::ptrdiff_t length, int column);
+        ErrorCode run(const char* text, int line, int column);
+
         const char* m_text_ptr = nullptr;
+        const char* m_end_ptr = nullptr;
         std::vector<token> m_tokens;
+        token_sink* m_sink = nullptr;
         ErrorCode m_error_code;
 
         int m_line;
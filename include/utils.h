@@ -29,7 +29,6 @@ namespace detail
         number_union nb;
     }; // number
 
-    bool parse_integer_base(number& num, const char* text, std::ptrdiff_t length, int base);
     std::string remove_escapes(std::string&& str);
 } // detail
 } // configparser
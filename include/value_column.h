@@ -0,0 +1,58 @@
+#ifndef CP_VALUE_COLUMN_H
+#define CP_VALUE_COLUMN_H
+
+#include "value_type.h"
+#include "span.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace configparser
+{
+namespace detail
+{
+    // the values of a list option that all have the same type, stored
+    // contiguously: longs and doubles as arrays, booleans as bits
+    class value_column
+    {
+    public:
+        value_column(ValueType type, std::size_t size, std::pmr::memory_resource* resource);
+        value_column(const value_column&) = delete;
+        value_column(value_column&&) = delete;
+        value_column& operator=(const value_column&) = delete;
+        value_column& operator=(value_column&&) = delete;
+        ~value_column();
+
+        // null unless all values are typed longs, doubles or booleans
+        static std::shared_ptr<value_column> build(const values_vector& values,
+            std::pmr::memory_resource* resource);
+        std::shared_ptr<value_column> copy(std::pmr::memory_resource* resource) const;
+
+        ValueType type() const noexcept;
+        std::size_t size() const noexcept;
+
+        // empty unless the column has that type
+        span<const long> longs() const noexcept;
+        span<const double> doubles() const noexcept;
+        // bit (i % 64) of word (i / 64) is value i
+        span<const std::uint64_t> bits() const noexcept;
+        bool bit(std::size_t idx) const noexcept;
+
+        // the column as tagged values, built once on first use
+        // and safe to call from multiple threads
+        const values_vector& values() const;
+
+    private:
+        ValueType m_type;
+        std::size_t m_size;
+        std::pmr::vector<long> m_longs;
+        std::pmr::vector<double> m_doubles;
+        std::pmr::vector<std::uint64_t> m_bits;
+        mutable std::atomic<values_vector*> m_values{ nullptr };
+    }; // value_column
+} // detail
+} // configparser
+
+#endif // CP_VALUE_COLUMN_H
@@ -2,7 +2,10 @@
 #define CP_VALUE_PARSER_H
 
 #include "utils.h"
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace configparser
 {
@@ -40,41 +43,41 @@ namespace detail
         number_parser& operator=(number_parser&&) = default;
         ~number_parser() = default;
 
+        // decimal, hexadecimal (0x), octal (0) and binary (0b)
+        // integers and decimal floating point numbers; a number
+        // out of the range of its type is rejected and reported
+        // through overflow() instead of being clamped
         bool parse(const char* text, std::ptrdiff_t length);
         const number& get() const;
+        bool overflow() const;
 
     private:
-        enum class InternalNumberType
-        {
-            NUMBER_HEXADECIMAL,
-            NUMBER_OCTAL,
-            NUMBER_BINARY,
-            NUMBER_INTEGER,
-            NUMBER_DOUBLE,
-
-            NUMBER_NUM
-        }; // InternalNumberType
-
-        static bool is_hexadecimal(const char* text, std::ptrdiff_t length);
-        static bool is_decimal(const char* text, std::ptrdiff_t length);
-        static bool is_octal(const char* text, std::ptrdiff_t length);
-        static bool is_binary(const char* text, std::ptrdiff_t length);
-
-        static InternalNumberType get_number_type(const char* text, std::ptrdiff_t length);
-
-        bool parse_hexadecimal(const char* text, std::ptrdiff_t length);
-        bool parse_octal(const char* text, std::ptrdiff_t length);
-        bool parse_binary(const char* text, std::ptrdiff_t length);
-        bool parse_integer(const char* text, std::ptrdiff_t length);
-        bool parse_double(const char* text, std::ptrdiff_t length);
+        bool parse_integer(const char* begin_ptr, const char* end_ptr, int base);
+        bool parse_double(const char* begin_ptr, const char* end_ptr);
 
         number m_number;
+        bool m_overflow = false;
     }; // number_parser
 
+    struct boolean_word
+    {
+        std::string word; // lowercase
+        bool value;
+    }; // boolean_word
+
+    // extra words recognized by a boolean_parser, compared ignoring
+    // ASCII case; built-in words take precedence; a list is never
+    // changed once shared, adding a word makes a new one
+    using boolean_words = std::vector<boolean_word>;
+
+    std::shared_ptr<const boolean_words> add_boolean_word(
+        const std::shared_ptr<const boolean_words>& words, std::string_view word, bool value);
+
     class boolean_parser
     {
     public:
         boolean_parser() = default;
+        explicit boolean_parser(const boolean_words* words) noexcept;
         boolean_parser(const boolean_parser&) = default;
         boolean_parser(boolean_parser&&) noexcept = default;
         boolean_parser& operator=(const boolean_parser&) = default;
@@ -85,9 +88,10 @@ namespace detail
         bool get() const;
 
     private:
-        static bool is_true(const char* text, std::ptrdiff_t length);
-        static bool is_false(const char* text, std::ptrdiff_t length);
+        bool parse_builtin(const char* text, std::ptrdiff_t length);
+        bool parse_user(const char* text, std::ptrdiff_t length);
 
+        const boolean_words* m_words = nullptr;
         bool m_boolean;
     }; // boolean_parser
 } // detail
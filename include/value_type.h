@@ -1,26 +1,38 @@
 #ifndef CP_VALUE_TYPE_H
 #define CP_VALUE_TYPE_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace configparser
 {
 namespace detail
 {
+    // string owned by values, shared by their copies
+    struct shared_string
+    {
+        explicit shared_string(std::string&& val) : str(std::move(val)) {}
+
+        std::atomic<std::uint32_t> refs{ 1 };
+        std::string str;
+    }; // shared_string
+
+    // 8 bytes, the rest of the value says which member is used
     union value_union
     {
         long l;
         double d;
         bool b;
-        std::string str;
-
-        value_union();
-        ~value_union();
+        const char* ptr; // borrowed string or raw text
+        shared_string* str; // owned string
     }; // value_union
 }
 
-    enum class ValueType
+    enum class ValueType : unsigned char
     {
         VALUE_LONG,
         VALUE_DOUBLE,
@@ -38,6 +50,24 @@ namespace detail
         value_type(bool val);
         value_type(std::string&& val);
 
+        // the longest borrowed string or raw text, from_view() and
+        // from_raw() throw std::length_error for longer ones
+        static constexpr size_t MAX_BORROWED_SIZE = UINT32_MAX;
+
+        // string value borrowing memory owned by someone else,
+        // e.g. a document parsed with DocumentMode::DOCUMENT_VIEW
+        static value_type from_view(std::string_view val);
+
+        // unparsed value, typed on first access; the raw text is
+        // borrowed like from_view() and, if it turns out to be a
+        // string without escapes, it stays borrowed when borrow_str
+        // is set and is copied into the value otherwise
+        static value_type from_raw(std::string_view raw, bool borrow_str);
+
+        // string value taking one more reference to a string held
+        // by others as well, e.g. the strings of a string_interner
+        static value_type from_shared(detail::shared_string* str);
+
         value_type(const value_type&);
         value_type(value_type&&) noexcept;
         value_type& operator=(const value_type&);
@@ -50,14 +80,49 @@ namespace detail
         long to_long() const;
         double to_double() const;
         bool to_bool() const;
+        // throws std::logic_error for a borrowed string (see
+        // is_borrowed()), to_view() works for both
         const std::string& to_str() const;
+        std::string_view to_view() const;
+
+        bool is_borrowed() const;
+        bool is_resolved() const;
 
     private:
-        detail::value_union m_value;
-        ValueType m_type = ValueType::VALUE_NUM;
+        enum class LazyState : unsigned char
+        {
+            LAZY_PENDING,
+            LAZY_RESOLVING,
+            LAZY_RESOLVED,
+
+            LAZY_NUM
+        }; // LazyState
+
+        // types a value made by from_raw(), safe to call
+        // from multiple threads reading the same value
+        void resolve() const;
+        void classify() const;
+        bool lock_pending() const;
+        void unlock_pending() const;
+
+        // copies the representation, sharing an owned string
+        void copy_from(const value_type& other, LazyState state);
+        void release();
+        std::string_view raw() const;
+
+        // 16 bytes: copies share owned strings, and moving a value
+        // copies the bytes and empties the moved one; it is not
+        // trivially copyable (copies count references and the lazy
+        // state is atomic), so values_vector growth moves values one
+        // by one, but without touching any reference count
+        mutable detail::value_union m_value{};
+        mutable std::uint32_t m_size = 0; // of a borrowed string or raw text
+        mutable ValueType m_type = ValueType::VALUE_NUM;
+        mutable bool m_borrowed = false;
+        mutable std::atomic<LazyState> m_state{ LazyState::LAZY_RESOLVED };
     }; // value_type
 
-    using values_vector = std::vector<value_type>;
+    using values_vector = std::pmr::vector<value_type>;
 
 } // configparser
 
@@ -0,0 +1,88 @@
+#include "batch.h"
+#include "parallel.h"
+#include <algorithm> // sort
+#include <filesystem> // file_size
+#include <system_error> // error_code
+
+namespace configparser
+{
+
+batch_input batch_input::from_file(std::string path)
+{
+    return { std::move(path), {}, true };
+}
+
+batch_input batch_input::from_text(std::string name, std::string text)
+{
+    return { std::move(name), std::move(text), false };
+}
+
+std::vector<batch_result> parse_batch(const std::vector<batch_input>& inputs,
+    const ConfigParser& settings, unsigned thread_count)
+{
+    std::vector<batch_result> results(inputs.size());
+
+    // the size is a good enough estimate of the work
+    std::vector<std::uintmax_t> sizes(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        if (inputs[i].is_file)
+        {
+            std::error_code ec;
+            sizes[i] = std::filesystem::file_size(inputs[i].name, ec);
+            if (ec)
+            {
+                sizes[i] = 0;
+            }
+        }
+        else
+        {
+            sizes[i] = inputs[i].text.size();
+        }
+    }
+
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    // like ConfigParser::is_parallel(), only the default heap is
+    // known to be thread safe; any other resource (or the upstream
+    // of every arena) would be used by all the threads at once
+    std::pmr::memory_resource* resource = (settings.memory_resource() != nullptr) ?
+        settings.memory_resource() :
+        std::pmr::get_default_resource();
+
+    if (resource != std::pmr::new_delete_resource())
+    {
+        thread_count = 1;
+    }
+
+    // files are loaded by the thread parsing them, so
+    // reading one overlaps with parsing the others
+    detail::thread_pool pool(thread_count);
+    pool.run(order.size(), [&](size_t i) {
+        const batch_input& input = inputs[order[i]];
+        batch_result& result = results[order[i]];
+
+        // every input is parsed on one thread,
+        // the pool already keeps all of them busy
+        ConfigParser& parser = result.parser;
+        parser.copy_settings(settings);
+        parser.set_thread_count(1);
+
+        result.name = input.name;
+        result.ok = input.is_file ?
+            parser.parse_file(input.name.c_str()) :
+            parser.parse_text(input.text.c_str());
+    });
+
+    return results;
+}
+
+} // configparser
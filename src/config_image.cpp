@@ -0,0 +1,807 @@
+#include "config_image.h"
+#include <cstddef> // offsetof
+#include <cstring> // memcmp, memcpy
+#include <filesystem> // rename, remove
+#include <fstream> // ifstream, ofstream
+#include <stdexcept> // out_of_range
+#include <system_error> // error_code
+#include <unordered_map>
+
+namespace configparser
+{
+
+namespace
+{
+    constexpr char IMAGE_MAGIC[8] = { 'C', 'P', 'I', 'M', 'A', 'G', 'E', '\0' };
+    // reads differently on a machine of the other byte order
+    constexpr std::uint32_t IMAGE_BYTE_ORDER = 0x01020304;
+
+    const detail::image_header& header_of(const char* base)
+    {
+        return *reinterpret_cast<const detail::image_header*>(base);
+    }
+
+    // everything after the checksum, the rest of the header included
+    std::string_view checksummed(const char* base, std::size_t size)
+    {
+        constexpr std::size_t from = offsetof(detail::image_header, checksum) + sizeof(std::uint64_t);
+        return { base + from, size - from };
+    }
+
+    template <typename Entry>
+    const Entry* table_of(const char* base, std::uint64_t offset)
+    {
+        return reinterpret_cast<const Entry*>(base + offset);
+    }
+
+    // the smallest power of two leaving every table at most half full
+    std::uint64_t slot_count_for(std::uint64_t count)
+    {
+        std::uint64_t slots = (count != 0) ? 2 : 0;
+        while (slots < 2 * count)
+        {
+            slots *= 2;
+        }
+
+        return slots;
+    }
+
+    // entries are found by the hash of their name and told
+    // apart by the name itself, the first one takes a name;
+    // at most every slot is probed, even in a damaged table
+    template <typename Equal>
+    std::uint64_t find_slot(const std::uint64_t* slots, std::uint64_t slot_count,
+        std::uint64_t hash, const Equal& equal)
+    {
+        const std::uint64_t mask = slot_count - 1;
+        std::uint64_t i = hash & mask;
+        for (std::uint64_t probes = 0; probes < slot_count; ++probes, i = (i + 1) & mask)
+        {
+            if ((slots[i] == 0) || equal(slots[i] - 1))
+            {
+                return slots[i];
+            }
+        }
+
+        return 0;
+    }
+
+    bool read_text(const char* filename, detail::mapped_file& file, std::string& text, std::string_view& view)
+    {
+        if (file.open(filename))
+        {
+            view = { file.data(), file.size() };
+            return true;
+        }
+
+        std::ifstream stream(filename, std::ios::binary);
+        if (!stream.is_open())
+        {
+            return false;
+        }
+
+        text.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        view = text;
+        return true;
+    }
+
+    class image_builder
+    {
+    public:
+        explicit image_builder(const ConfigParser& parser)
+            : m_parser(parser)
+        {}
+
+        std::string build(std::uint64_t source_hash);
+
+    private:
+        std::uint64_t add_string(std::string_view str);
+
+        // entries are written through offsets, as adding
+        // strings may move the image
+        template <typename Entry>
+        Entry* at(std::uint64_t offset)
+        {
+            return reinterpret_cast<Entry*>(&m_image[offset]);
+        }
+
+        template <typename Entry>
+        void fill_slots(std::uint64_t* slots, std::uint64_t slot_count,
+            const Entry* entries, std::uint64_t count);
+
+        const ConfigParser& m_parser;
+
+        std::string m_image;
+        // names repeat across sections, so do many values
+        std::unordered_map<std::string_view, std::uint64_t> m_string_offsets;
+    }; // image_builder
+
+    std::uint64_t image_builder::add_string(std::string_view str)
+    {
+        const auto it = m_string_offsets.find(str);
+        if (it != m_string_offsets.end())
+        {
+            return it->second;
+        }
+
+        const std::uint64_t offset = m_image.size();
+        m_image.append(str.data(), str.size());
+        m_image.push_back('\0');
+
+        m_string_offsets.emplace(str, offset);
+        return offset;
+    }
+
+    template <typename Entry>
+    void image_builder::fill_slots(std::uint64_t* slots, std::uint64_t slot_count,
+        const Entry* entries, std::uint64_t count)
+    {
+        const char* base = m_image.data();
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            const Entry& entry = entries[i];
+            const std::string_view name{ base + entry.name, entry.name_size };
+
+            const std::uint64_t mask = slot_count - 1;
+            for (std::uint64_t s = entry.name_hash & mask; ; s = (s + 1) & mask)
+            {
+                if (slots[s] == 0)
+                {
+                    slots[s] = i + 1;
+                    break;
+                }
+
+                const Entry& other = entries[slots[s] - 1];
+                if ((other.name_hash == entry.name_hash) &&
+                    (std::string_view{ base + other.name, other.name_size } == name))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    std::string image_builder::build(std::uint64_t source_hash)
+    {
+        const section_vector& sections = m_parser.sections();
+
+        // the tables are laid out first, their sizes are known
+        // before any string is added behind them
+        std::uint64_t option_count = 0;
+        std::uint64_t value_count = 0;
+        std::uint64_t slot_count = slot_count_for(sections.size());
+        for (const section_type& sct : sections)
+        {
+            option_count += sct.options().size();
+            slot_count += slot_count_for(sct.options().size());
+            for (const option_type& opt : sct.options())
+            {
+                value_count += opt.size();
+            }
+        }
+
+        detail::image_header h{};
+        std::memcpy(h.magic, IMAGE_MAGIC, sizeof(h.magic));
+        h.version = config_image::VERSION;
+        h.byte_order = IMAGE_BYTE_ORDER;
+        h.source_hash = source_hash;
+        h.section_count = sections.size();
+        h.option_count = option_count;
+        h.value_count = value_count;
+        h.sections = sizeof(detail::image_header);
+        h.options = h.sections + h.section_count * sizeof(detail::image_section_entry);
+        h.values = h.options + h.option_count * sizeof(detail::image_option_entry);
+        h.slots = h.values + h.value_count * sizeof(detail::image_value_entry);
+        h.slot_count = slot_count;
+        h.section_slots = h.slots;
+        h.section_slot_count = slot_count_for(sections.size());
+        m_image.assign(h.slots + h.slot_count * sizeof(std::uint64_t), '\0');
+
+        std::uint64_t option_idx = 0;
+        std::uint64_t value_idx = 0;
+        std::uint64_t slots = h.section_slots + h.section_slot_count * sizeof(std::uint64_t);
+        for (std::uint64_t s = 0; s < sections.size(); ++s)
+        {
+            const section_type& sct = sections[s];
+            const std::uint64_t name = add_string(sct.name());
+
+            detail::image_section_entry* se = at<detail::image_section_entry>(
+                h.sections + s * sizeof(detail::image_section_entry));
+            se->name = name;
+            se->name_size = sct.name().size();
+            se->name_hash = detail::hash_key(sct.name());
+            se->first_option = option_idx;
+            se->option_count = sct.options().size();
+            se->option_slots = slots;
+            se->option_slot_count = slot_count_for(sct.options().size());
+            slots += se->option_slot_count * sizeof(std::uint64_t);
+
+            for (const option_type& opt : sct.options())
+            {
+                const std::uint64_t opt_name = add_string(opt.name());
+
+                detail::image_option_entry* oe = at<detail::image_option_entry>(
+                    h.options + option_idx * sizeof(detail::image_option_entry));
+                oe->name = opt_name;
+                oe->name_size = opt.name().size();
+                oe->name_hash = detail::hash_key(opt.name());
+                oe->first_value = value_idx;
+                oe->value_count = opt.size();
+                ++option_idx;
+
+                // by index, so that columns are read in place
+                for (size_t i = 0; i < opt.size(); ++i)
+                {
+                    detail::image_value_entry ve{};
+                    const ValueType type = opt.get_type(i);
+                    ve.type = (std::uint32_t)type;
+                    switch (type)
+                    {
+                        case ValueType::VALUE_LONG:
+                            ve.l = opt.get<long>(i);
+                            break;
+                        case ValueType::VALUE_DOUBLE:
+                            ve.d = opt.get<double>(i);
+                            break;
+                        case ValueType::VALUE_BOOLEAN:
+                            ve.b = opt.get<bool>(i);
+                            break;
+                        case ValueType::VALUE_STRING:
+                            ve.size = (std::uint32_t)opt.get_view(i).size();
+                            ve.str = add_string(opt.get_view(i));
+                            break;
+                        default: // should never happen
+                            break;
+                    }
+
+                    *at<detail::image_value_entry>(h.values + value_idx * sizeof(detail::image_value_entry)) = ve;
+                    ++value_idx;
+                }
+            }
+        }
+
+        // strings are in place, the names can be hashed into the slots
+        const char* base = m_image.data();
+        fill_slots(at<std::uint64_t>(h.section_slots), h.section_slot_count,
+            table_of<detail::image_section_entry>(base, h.sections), h.section_count);
+
+        for (std::uint64_t s = 0; s < h.section_count; ++s)
+        {
+            const detail::image_section_entry& se = table_of<detail::image_section_entry>(base, h.sections)[s];
+            fill_slots(at<std::uint64_t>(se.option_slots), se.option_slot_count,
+                table_of<detail::image_option_entry>(base, h.options) + se.first_option, se.option_count);
+        }
+
+        // keeps the next image in a file 8 byte aligned
+        m_image.resize((m_image.size() + 7) & ~(std::size_t)7, '\0');
+
+        h.size = m_image.size();
+        std::memcpy(&m_image[0], &h, sizeof(h));
+        h.checksum = detail::hash_key(checksummed(m_image.data(), m_image.size()));
+        std::memcpy(&m_image[0], &h, sizeof(h));
+
+        return std::move(m_image);
+    }
+} // anonymous
+
+ValueType image_value::type() const
+{
+    return (ValueType)m_entry->type;
+}
+
+bool image_value::has_type(ValueType type) const
+{
+    return this->type() == type;
+}
+
+long image_value::to_long() const
+{
+    return (long)m_entry->l;
+}
+
+double image_value::to_double() const
+{
+    return m_entry->d;
+}
+
+bool image_value::to_bool() const
+{
+    return m_entry->b != 0;
+}
+
+std::string_view image_value::to_view() const
+{
+    return { m_base + m_entry->str, m_entry->size };
+}
+
+template <>
+long image_option::get<long>(size_t idx) const
+{
+    return values()[idx].to_long();
+}
+
+template <>
+double image_option::get<double>(size_t idx) const
+{
+    return values()[idx].to_double();
+}
+
+template <>
+bool image_option::get<bool>(size_t idx) const
+{
+    return values()[idx].to_bool();
+}
+
+template <>
+std::string_view image_option::get<std::string_view>(size_t idx) const
+{
+    return values()[idx].to_view();
+}
+
+template <>
+bool image_option::get<long>(size_t idx, long& val) const
+{
+    if ((idx < size()) &&
+        (values()[idx].has_type(ValueType::VALUE_LONG)))
+    {
+        val = values()[idx].to_long();
+        return true;
+    }
+
+    return false;
+}
+
+template <>
+bool image_option::get<double>(size_t idx, double& val) const
+{
+    if ((idx < size()) &&
+        (values()[idx].has_type(ValueType::VALUE_DOUBLE)))
+    {
+        val = values()[idx].to_double();
+        return true;
+    }
+
+    return false;
+}
+
+template <>
+bool image_option::get<bool>(size_t idx, bool& val) const
+{
+    if ((idx < size()) &&
+        (values()[idx].has_type(ValueType::VALUE_BOOLEAN)))
+    {
+        val = values()[idx].to_bool();
+        return true;
+    }
+
+    return false;
+}
+
+template <>
+bool image_option::get<std::string>(size_t idx, std::string& val) const
+{
+    if ((idx < size()) &&
+        (values()[idx].has_type(ValueType::VALUE_STRING)))
+    {
+        val = std::string(values()[idx].to_view());
+        return true;
+    }
+
+    return false;
+}
+
+template <>
+bool image_option::get<std::string_view>(size_t idx, std::string_view& val) const
+{
+    if ((idx < size()) &&
+        (values()[idx].has_type(ValueType::VALUE_STRING)))
+    {
+        val = values()[idx].to_view();
+        return true;
+    }
+
+    return false;
+}
+
+ValueType image_option::get_type() const
+{
+    return get_type(0);
+}
+
+ValueType image_option::get_type(size_t idx) const
+{
+    return values()[idx].type();
+}
+
+size_t image_option::size() const
+{
+    return m_entry->value_count;
+}
+
+bool image_option::is_vector() const
+{
+    return (size() > 1);
+}
+
+detail::image_range<image_value> image_option::values() const
+{
+    const auto* values = table_of<detail::image_value_entry>(m_base, header_of(m_base).values);
+    return { m_base, values + m_entry->first_value, m_entry->value_count };
+}
+
+std::string_view image_option::name() const
+{
+    return { m_base + m_entry->name, m_entry->name_size };
+}
+
+detail::image_range<image_option> image_section::options() const
+{
+    const auto* options = table_of<detail::image_option_entry>(m_base, header_of(m_base).options);
+    return { m_base, options + m_entry->first_option, m_entry->option_count };
+}
+
+image_option image_section::option(std::string_view option_name) const
+{
+    const std::optional<image_option> opt = find_option(option_name);
+    if (!opt)
+    {
+        throw std::out_of_range("configparser: no such option");
+    }
+
+    return *opt;
+}
+
+std::optional<image_option> image_section::find_option(std::string_view option_name) const noexcept
+{
+    return find_option(option_name, detail::hash_key(option_name));
+}
+
+std::optional<image_option> image_section::find_option(std::string_view option_name, std::uint64_t hash) const noexcept
+{
+    const auto* options = table_of<detail::image_option_entry>(m_base, header_of(m_base).options) + m_entry->first_option;
+    const std::uint64_t slot = find_slot(
+        table_of<std::uint64_t>(m_base, m_entry->option_slots), m_entry->option_slot_count, hash,
+        [&](std::uint64_t idx) {
+            return (options[idx].name_hash == hash) &&
+                (std::string_view{ m_base + options[idx].name, options[idx].name_size } == option_name);
+        });
+
+    if (slot == 0)
+    {
+        return std::nullopt;
+    }
+
+    return image_option(m_base, options + slot - 1);
+}
+
+bool image_section::has_option(std::string_view option_name) const noexcept
+{
+    return find_option(option_name).has_value();
+}
+
+std::string_view image_section::name() const
+{
+    return { m_base + m_entry->name, m_entry->name_size };
+}
+
+bool config_image::open(const char* filename, bool verify_checksum)
+{
+    close();
+
+    // the mapping starts at a page, so the tables are aligned;
+    // a buffer of 8 byte words keeps them aligned as well
+    if (m_file.open(filename))
+    {
+        m_data = m_file.data();
+        m_size = m_file.size();
+    }
+    else
+    {
+        std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+        if (!stream.is_open())
+        {
+            return false;
+        }
+
+        m_size = (std::size_t)stream.tellg();
+        m_buffer.resize((m_size + 7) / 8);
+        stream.seekg(0);
+        if (!stream.read(reinterpret_cast<char*>(m_buffer.data()), (std::streamsize)m_size))
+        {
+            close();
+            return false;
+        }
+
+        m_data = reinterpret_cast<const char*>(m_buffer.data());
+    }
+
+    if (!check(verify_checksum))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool config_image::check(bool verify_checksum) const
+{
+    if (m_size < sizeof(detail::image_header))
+    {
+        return false;
+    }
+
+    const detail::image_header& h = header();
+    if ((std::memcmp(h.magic, IMAGE_MAGIC, sizeof(h.magic)) != 0) ||
+        (h.version != VERSION) ||
+        (h.byte_order != IMAGE_BYTE_ORDER) ||
+        (h.size != m_size))
+    {
+        return false;
+    }
+
+    // every table lies within the image
+    const auto fits = [this](std::uint64_t offset, std::uint64_t count, std::size_t size) {
+        return (offset % 8 == 0) && (offset <= m_size) && (count <= (m_size - offset) / size);
+    };
+
+    if (!fits(h.sections, h.section_count, sizeof(detail::image_section_entry)) ||
+        !fits(h.options, h.option_count, sizeof(detail::image_option_entry)) ||
+        !fits(h.values, h.value_count, sizeof(detail::image_value_entry)) ||
+        !fits(h.slots, h.slot_count, sizeof(std::uint64_t)) ||
+        !fits(h.section_slots, h.section_slot_count, sizeof(std::uint64_t)))
+    {
+        return false;
+    }
+
+    // and so does everything the entries point to, so a damaged
+    // image is rejected here rather than read out of bounds later
+    const auto string_fits = [this](std::uint64_t offset, std::uint64_t size) {
+        return (offset < m_size) && (size < m_size - offset) && (m_data[offset + size] == '\0');
+    };
+
+    // none without entries, otherwise a power of two with at least
+    // one empty slot to end a probe, and every slot empty or the
+    // index + 1 of one of count entries
+    const auto slots_fit = [&](std::uint64_t offset, std::uint64_t slot_count, std::uint64_t count) {
+        if (slot_count == 0)
+        {
+            return count == 0;
+        }
+
+        if ((slot_count <= count) || ((slot_count & (slot_count - 1)) != 0) ||
+            !fits(offset, slot_count, sizeof(std::uint64_t)))
+        {
+            return false;
+        }
+
+        const std::uint64_t* slots = table_of<std::uint64_t>(m_data, offset);
+        for (std::uint64_t i = 0; i < slot_count; ++i)
+        {
+            if (slots[i] > count)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    if (!slots_fit(h.section_slots, h.section_slot_count, h.section_count))
+    {
+        return false;
+    }
+
+    const auto* sections = table_of<detail::image_section_entry>(m_data, h.sections);
+    for (std::uint64_t i = 0; i < h.section_count; ++i)
+    {
+        const detail::image_section_entry& se = sections[i];
+        if (!string_fits(se.name, se.name_size) ||
+            (se.first_option > h.option_count) ||
+            (se.option_count > h.option_count - se.first_option) ||
+            !slots_fit(se.option_slots, se.option_slot_count, se.option_count))
+        {
+            return false;
+        }
+    }
+
+    const auto* options = table_of<detail::image_option_entry>(m_data, h.options);
+    for (std::uint64_t i = 0; i < h.option_count; ++i)
+    {
+        const detail::image_option_entry& oe = options[i];
+        if (!string_fits(oe.name, oe.name_size) ||
+            (oe.first_value > h.value_count) ||
+            (oe.value_count > h.value_count - oe.first_value))
+        {
+            return false;
+        }
+    }
+
+    const auto* values = table_of<detail::image_value_entry>(m_data, h.values);
+    for (std::uint64_t i = 0; i < h.value_count; ++i)
+    {
+        const detail::image_value_entry& ve = values[i];
+        if ((ve.type >= (std::uint32_t)ValueType::VALUE_NUM) ||
+            ((ve.type == (std::uint32_t)ValueType::VALUE_STRING) && !string_fits(ve.str, ve.size)))
+        {
+            return false;
+        }
+    }
+
+    if (verify_checksum)
+    {
+        return detail::hash_key(checksummed(m_data, m_size)) == h.checksum;
+    }
+
+    return true;
+}
+
+void config_image::close()
+{
+    m_file.close();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool config_image::is_open() const
+{
+    return m_data != nullptr;
+}
+
+const detail::image_header& config_image::header() const
+{
+    return header_of(m_data);
+}
+
+detail::image_range<image_section> config_image::sections() const
+{
+    if (!is_open())
+    {
+        return { nullptr, nullptr, 0 };
+    }
+
+    return { m_data, table_of<detail::image_section_entry>(m_data, header().sections), header().section_count };
+}
+
+image_section config_image::get_section(std::string_view section_name) const
+{
+    const std::optional<image_section> sct = find_section(section_name);
+    if (!sct)
+    {
+        throw std::out_of_range("configparser: no such section");
+    }
+
+    return *sct;
+}
+
+image_option config_image::option(std::string_view section_name, std::string_view option_name) const
+{
+    return get_section(section_name).option(option_name);
+}
+
+std::optional<image_section> config_image::find_section(std::string_view section_name) const noexcept
+{
+    return find_section(section_name, detail::hash_key(section_name));
+}
+
+std::optional<image_section> config_image::find_section(std::string_view section_name, std::uint64_t hash) const noexcept
+{
+    if (!is_open())
+    {
+        return std::nullopt;
+    }
+
+    const detail::image_header& h = header();
+    const auto* sections = table_of<detail::image_section_entry>(m_data, h.sections);
+    const std::uint64_t slot = find_slot(
+        table_of<std::uint64_t>(m_data, h.section_slots), h.section_slot_count, hash,
+        [&](std::uint64_t idx) {
+            return (sections[idx].name_hash == hash) &&
+                (std::string_view{ m_data + sections[idx].name, sections[idx].name_size } == section_name);
+        });
+
+    if (slot == 0)
+    {
+        return std::nullopt;
+    }
+
+    return image_section(m_data, sections + slot - 1);
+}
+
+std::optional<image_option> config_image::find_option(std::string_view section_name, std::string_view option_name) const noexcept
+{
+    const std::optional<image_section> sct = find_section(section_name);
+    return sct ? sct->find_option(option_name) : std::nullopt;
+}
+
+std::optional<image_option> config_image::find_option(const option_key& key) const noexcept
+{
+    const std::optional<image_section> sct = find_section(key.section_name(), key.section_hash());
+    return sct ? sct->find_option(key.option_name(), key.option_hash()) : std::nullopt;
+}
+
+bool config_image::has_section(std::string_view section_name) const noexcept
+{
+    return find_section(section_name).has_value();
+}
+
+bool config_image::has_option(std::string_view section_name, std::string_view option_name) const noexcept
+{
+    return find_option(section_name, option_name).has_value();
+}
+
+std::uint64_t config_image::source_hash() const
+{
+    return is_open() ? header().source_hash : 0;
+}
+
+bool config_image::is_stale(const char* source_filename) const
+{
+    detail::mapped_file file;
+    std::string text;
+    std::string_view view;
+    if (!is_open() || !read_text(source_filename, file, text, view))
+    {
+        return true;
+    }
+
+    return hash_source(view) != source_hash();
+}
+
+std::uint64_t config_image::hash_source(std::string_view text)
+{
+    return detail::hash_key(text);
+}
+
+bool config_image::write(const ConfigParser& parser, const char* filename, std::uint64_t source_hash)
+{
+    const std::string image = image_builder(parser).build(source_hash);
+
+    // written aside and renamed over the previous image
+    const std::string temp = std::string(filename) + ".tmp";
+    {
+        std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+        if (!stream.write(image.data(), (std::streamsize)image.size()) || !stream.flush())
+        {
+            std::error_code ec;
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, filename, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool config_image::compile(const char* source_filename, const char* filename, const ConfigParser& settings)
+{
+    detail::mapped_file file;
+    std::string text;
+    std::string_view view;
+    if (!read_text(source_filename, file, text, view))
+    {
+        return false;
+    }
+
+    // the mapped text is NUL terminated, so is the string
+    ConfigParser parser;
+    parser.copy_settings(settings);
+
+    if (!parser.parse_text(view.data()))
+    {
+        return false;
+    }
+
+    return write(parser, filename, hash_source(view));
+}
+
+} // configparser
@@ -1,37 +1,172 @@
 #include "configparser.h"
 #include "value_parser.h"
 #include "tokenizer.h"
+#include "mapped_file.h"
+#include "parallel.h"
 
 #include <fstream> // ifstream
+#include <istream> // istream
 #include <cassert> // assert
+#include <algorithm> // lower_bound, max
+#include <atomic>
+#include <unordered_map> // unordered_map, unordered_multimap
+#include <cerrno> // errno
+#include <cstring> // memchr, strlen
+#include <stdexcept> // out_of_range
+
+#ifdef _WIN32
+#include <io.h> // _read
+#else
+#include <unistd.h> // read
+#endif
 
 namespace configparser
 {
 
-void ConfigParser::parse_value(values_vector& values, const detail::token& t)
+class ConfigParser::parser_sink : public detail::token_sink
+{
+public:
+    explicit parser_sink(ConfigParser& parser) :
+        m_parser(parser)
+    {}
+
+    void on_token(const detail::token& t) override
+    {
+        m_parser.parse_token(t);
+    }
+
+private:
+    ConfigParser& m_parser;
+}; // parser_sink
+
+static std::uint64_t next_generation()
+{
+    // unique across parsers, so a handle from
+    // one parser is never valid for another
+    static std::atomic<std::uint64_t> generation{ 0 };
+    return ++generation;
+}
+
+// smaller texts and levels with fewer nodes
+// are not worth the threads
+static constexpr size_t PARALLEL_PARSE_MIN = 1024 * 1024;
+static constexpr size_t PARALLEL_PART_MIN = 256 * 1024;
+static constexpr size_t PARALLEL_LINKS_MIN = 256;
+
+// splits [0, count) into a few chunks per thread, so that
+// threads running out of work can steal some
+static void run_chunks(detail::thread_pool& pool, size_t count,
+    const std::function<void(size_t, size_t)>& body)
+{
+    const size_t chunks = std::min(count, pool.size() * 4);
+    pool.run(chunks, [count, chunks, &body](size_t i) {
+        body(i * count / chunks, (i + 1) * count / chunks);
+    });
+}
+
+static std::ptrdiff_t read_fd(int fd, char* buffer, size_t size)
+{
+#ifdef _WIN32
+    return _read(fd, buffer, (unsigned int)size);
+#else
+    return read(fd, buffer, size);
+#endif
+}
+
+// istreambuf_iterator lets a failing read throw (reading a
+// directory, say), read() reports it as badbit instead
+static bool read_stream(std::istream& stream, std::string& str)
+{
+    while (stream)
+    {
+        const size_t size = str.size();
+        str.resize(size + ConfigParser::DEFAULT_CHUNK_SIZE);
+        stream.read(&str[size], (std::streamsize)ConfigParser::DEFAULT_CHUNK_SIZE);
+        str.resize(size + (size_t)stream.gcount());
+    }
+
+    return !stream.bad();
+}
+
+bool ConfigParser::parse_value(option_type& option, const detail::token& t)
 {
     detail::link_parser lp;
     if (lp.parse(t.begin_ptr, t.length))
     {
-        const auto it = m_sections_map.find(lp.section());
-        if (it != m_sections_map.end())
+        const size_t section_idx = m_sections->size() - 1;
+        const size_t option_idx = m_sections->back().m_options.size() - 1;
+
+        if (m_incremental)
         {
-            const auto& scts = m_sections[it->second];
+            m_records.back().links.push_back(store_name({ t.begin_ptr + 2, lp.section().size() }));
+        }
+
+        // an earlier option that is already complete is linked
+        // right away, the rest waits for the whole document
+        const auto it = m_defer_links ? m_sections_map->end() : m_sections_map->find(lp.section());
+        if (it != m_sections_map->end())
+        {
+            auto& scts = (*m_sections)[it->second];
             const auto it2 = scts.m_options_map.find(lp.option());
-            if (it2 != scts.m_options_map.end())
+            if ((it2 != scts.m_options_map.end()) &&
+                ((it->second != section_idx) || (it2->second != option_idx)) &&
+                !has_pending_links(it->second, it2->second))
             {
-                const values_vector& other_values = scts.m_options[it2->second].m_values;
-                std::copy(other_values.begin(), other_values.end(), std::back_inserter(values));
-                return;
+                // the linked values are shared, not copied
+                option.link_values(scts.m_options[it2->second]);
+                return true;
             }
         }
+
+        // the link text is kept as a plain value, it is replaced
+        // by the linked values once the whole document is parsed
+        const char* section_ptr = t.begin_ptr + 2; // skip '${'
+        const char* option_ptr = section_ptr + lp.section().size() + 1; // skip '#'
+
+        const std::string_view section_name = store_name({ section_ptr, lp.section().size() });
+        m_links.push_back({ section_idx, option_idx, option.values().size(),
+            section_name,
+            store_name({ option_ptr, lp.option().size() }),
+            t.line, t.column });
+    }
+
+    values_vector& values = option.own_values();
+    const bool intern_values = (m_interner != nullptr) && (m_intern_mode == InternMode::INTERN_ALL);
+
+    // borrowed texts have a 32 bit size, longer values are copied
+    const bool borrowable = (size_t)t.length <= value_type::MAX_BORROWED_SIZE;
+
+    if ((m_value_mode == ValueMode::VALUE_LAZY) && borrowable)
+    {
+        // only the range is checked, typing stays lazy
+        detail::number_parser np;
+        if ((m_number_mode == NumberMode::NUMBER_STRICT) &&
+            !np.parse(t.begin_ptr, t.length) && np.overflow())
+        {
+            set_error(ErrorCode::NUMBER_OUT_OF_RANGE, t.line, t.column);
+            return false;
+        }
+
+        // lazy values are typed with the built-in words only,
+        // so the extra words of the parser are matched here
+        detail::boolean_parser bp(m_boolean_words.get());
+        if ((m_boolean_words != nullptr) && bp.parse(t.begin_ptr, t.length))
+        {
+            values.emplace_back(bp.get());
+            return true;
+        }
+
+        const std::string_view text{ t.begin_ptr, (size_t)t.length };
+        const std::string_view raw = intern_values ? m_interner->intern(text) : store_string(text);
+        values.push_back(value_type::from_raw(raw, m_document_mode == DocumentMode::DOCUMENT_VIEW));
+        return true;
     }
 
-    detail::boolean_parser bp;
+    detail::boolean_parser bp(m_boolean_words.get());
     if (bp.parse(t.begin_ptr, t.length))
     {
         values.emplace_back(bp.get());
-        return;
+        return true;
     }
 
     detail::number_parser np;
@@ -41,199 +176,1695 @@ void ConfigParser::parse_value(values_vector& values, const detail::token& t)
         {
             case detail::NumberType::NUMBER_LONG:
                 values.emplace_back(np.get().nb.l);
-                return;
+                return true;
             case detail::NumberType::NUMBER_DOUBLE:
                 values.emplace_back(np.get().nb.d);
-                return;
+                return true;
             default: // should NEVER get here
                 assert(false);
                 break;
         }
     }
 
+    if (np.overflow() && (m_number_mode == NumberMode::NUMBER_STRICT))
+    {
+        set_error(ErrorCode::NUMBER_OUT_OF_RANGE, t.line, t.column);
+        return false;
+    }
+
+    // interned strings are shared by the values in both modes
+    if (intern_values)
+    {
+        const std::string_view str{ t.begin_ptr, (size_t)t.length };
+        if (str.find('\\') == std::string_view::npos)
+        {
+            values.push_back(m_interner->intern_value(str));
+        }
+        else
+        {
+            values.push_back(m_interner->intern_value(detail::remove_escapes(std::string{ str })));
+        }
+
+        return true;
+    }
+
+    if ((m_document_mode == DocumentMode::DOCUMENT_VIEW) && borrowable)
+    {
+        const std::string_view str{ t.begin_ptr, (size_t)t.length };
+        if (str.find('\\') == std::string_view::npos)
+        {
+            values.push_back(value_type::from_view(store_string(str)));
+        }
+        else
+        {
+            const std::string unescaped = detail::remove_escapes(std::string{ str });
+            values.push_back(value_type::from_view(m_strings->store(unescaped)));
+        }
+
+        return true;
+    }
+
     values.emplace_back(detail::remove_escapes(std::string{ t.begin_ptr, (size_t)t.length }));
+    return true;
+}
+
+bool ConfigParser::is_parallel() const
+{
+    // arenas and the string pool are not thread safe,
+    // the default heap is
+    return (detail::effective_thread_count(m_thread_count) > 1) &&
+        (m_sections->get_allocator().resource() == std::pmr::new_delete_resource());
 }
 
-bool ConfigParser::parse_tokens(const std::vector<detail::token>& tokens)
+bool ConfigParser::has_pending_links(size_t section_idx, size_t option_idx) const
 {
-    auto it = tokens.begin();
-    if (it->type != detail::TokenType::TOKEN_SECTION)
+    // links are recorded in document order
+    const auto it = std::lower_bound(m_links.begin(), m_links.end(), std::make_pair(section_idx, option_idx),
+        [](const pending_link& link, const std::pair<size_t, size_t>& idx) {
+            return std::make_pair(link.section_idx, link.option_idx) < idx;
+        });
+
+    return (it != m_links.end()) &&
+        (it->section_idx == section_idx) &&
+        (it->option_idx == option_idx);
+}
+
+std::string_view ConfigParser::store_string(std::string_view str)
+{
+    // tokens point into the kept text only when the whole
+    // text is parsed at once, streamed chunks are reused
+    return m_borrow_text ? str : m_strings->store(str);
+}
+
+std::string_view ConfigParser::store_name(std::string_view str)
+{
+    return (m_interner != nullptr) ? m_interner->intern(str) : store_string(str);
+}
+
+void ConfigParser::set_error(ErrorCode error_code, int line, int column)
+{
+    m_error_code = error_code;
+    m_error_line = line;
+    m_error_column = column;
+    m_parse_state = ParseState::STATE_ERROR;
+}
+
+ConfigParser::ConfigParser()
+{
+    reset_document();
+}
+
+ConfigParser::ConfigParser(ConfigParser&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+ConfigParser& ConfigParser::operator=(const ConfigParser& other)
+{
+    if (this != &other)
     {
-        m_error_code = ErrorCode::EXPECTED_SECTION_FIRST;
-        m_error_line = it->line;
-        m_error_column = it->column;
-        return false;
+        ConfigParser copy(other);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+ConfigParser& ConfigParser::operator=(ConfigParser&& other) noexcept
+{
+    if (this != &other)
+    {
+        // the current containers go before the arena they
+        // allocate from; once released, the optionals are move
+        // constructed, which keeps the memory resource of other
+        // (assigning pmr containers would copy into the old one)
+        release_document();
+
+        m_memory_mode = other.m_memory_mode;
+        m_memory_resource = other.m_memory_resource;
+        m_arena = std::move(other.m_arena);
+        m_sections = std::move(other.m_sections);
+        m_sections_map = std::move(other.m_sections_map);
+        m_sections_index = std::move(other.m_sections_index);
+
+        m_value_mode = other.m_value_mode;
+        m_number_mode = other.m_number_mode;
+        m_boolean_words = std::move(other.m_boolean_words);
+        m_document_mode = other.m_document_mode;
+        m_text_owner = std::move(other.m_text_owner);
+        m_strings = std::move(other.m_strings);
+        m_borrow_text = other.m_borrow_text;
+
+        m_intern_mode = other.m_intern_mode;
+        m_shared_interner = std::move(other.m_shared_interner);
+        m_interner = std::move(other.m_interner);
+
+        m_generation = other.m_generation;
+        m_links = std::move(other.m_links);
+        m_defer_links = other.m_defer_links;
+
+        m_records = std::move(other.m_records);
+        m_incremental = other.m_incremental;
+        m_dead_bytes = other.m_dead_bytes;
+        m_thread_count = other.m_thread_count;
+
+        m_parse_state = other.m_parse_state;
+        m_identifier_line = other.m_identifier_line;
+        m_identifier_column = other.m_identifier_column;
+
+        m_feed_buffer = std::move(other.m_feed_buffer);
+        m_feed_line = other.m_feed_line;
+        m_feed_column = other.m_feed_column;
+        m_feed_stopped = other.m_feed_stopped;
+
+        m_error_code = other.m_error_code;
+        m_error_line = other.m_error_line;
+        m_error_column = other.m_error_column;
+
+        // a moved from container may allocate again from the
+        // arena other no longer keeps alive
+        other.release_document();
+    }
+
+    return *this;
+}
+
+void ConfigParser::copy_settings(const ConfigParser& other)
+{
+    m_document_mode = other.m_document_mode;
+    m_memory_mode = other.m_memory_mode;
+    m_memory_resource = other.m_memory_resource;
+    m_value_mode = other.m_value_mode;
+    m_number_mode = other.m_number_mode;
+    m_boolean_words = other.m_boolean_words;
+    m_intern_mode = other.m_intern_mode;
+    m_shared_interner = other.m_shared_interner;
+    m_thread_count = other.m_thread_count;
+}
+
+void ConfigParser::release_document() noexcept
+{
+    // everything allocated from the previous arena is
+    // destroyed before the arena itself is released
+    m_sections_index.reset();
+    m_sections.reset();
+    m_sections_map.reset();
+    m_strings.reset();
+    m_interner.reset();
+    m_arena.reset();
+}
+
+// whatever was parsed before the input failed is dropped
+bool ConfigParser::read_failed()
+{
+    parse_begin();
+    set_error(ErrorCode::READ_ERROR, 0, 0);
+
+    return false;
+}
+
+void ConfigParser::reset_document()
+{
+    release_document();
+
+    std::pmr::memory_resource* resource = (m_memory_resource != nullptr) ?
+        m_memory_resource :
+        std::pmr::get_default_resource();
+
+    if (m_memory_mode == MemoryMode::MEMORY_ARENA)
+    {
+        m_arena = std::make_shared<std::pmr::monotonic_buffer_resource>(resource);
+        resource = m_arena.get();
+    }
+
+    m_sections.emplace(resource);
+    m_sections_map.emplace(resource);
+    m_sections_index.emplace(resource);
+
+    // the previous strings may still be used by a copy,
+    // which then also keeps the previous arena alive
+    m_strings = std::make_shared<detail::string_pool>(resource, m_arena);
+
+    if (m_intern_mode != InternMode::INTERN_NONE)
+    {
+        m_interner = (m_shared_interner != nullptr) ?
+            m_shared_interner :
+            std::make_shared<string_interner>();
     }
+}
 
-    m_sections_map.emplace(
-        std::string{ it->begin_ptr, (size_t)it->length },
-        m_sections.size());
+void ConfigParser::parse_begin()
+{
+    reset_document();
+
+    m_text_owner.reset();
+    m_borrow_text = false;
+    m_generation = next_generation();
+    m_links.clear();
+    m_records.clear();
+    m_incremental = false;
+    m_dead_bytes = 0;
 
-    m_sections.emplace_back(
-        std::string{ it->begin_ptr, (size_t)it->length });
+    m_error_code = ErrorCode::NO_ERROR;
+    m_parse_state = ParseState::STATE_EXPECT_SECTION;
+}
 
-    for (++it; it != tokens.end(); ++it)
+bool ConfigParser::parse_token(const detail::token& t)
+{
+    switch (m_parse_state)
     {
-        switch (it->type)
+        case ParseState::STATE_EXPECT_SECTION:
         {
-            case detail::TokenType::TOKEN_SECTION:
+            if (t.type != detail::TokenType::TOKEN_SECTION)
             {
-                m_sections_map.emplace(
-                    std::string{ it->begin_ptr, (size_t)it->length },
-                    m_sections.size());
-
-                m_sections.emplace_back(
-                    std::string{ it->begin_ptr, (size_t)it->length });
+                set_error(ErrorCode::EXPECTED_SECTION_FIRST, t.line, t.column);
+                return false;
             }
-            break;
-            case detail::TokenType::TOKEN_IDENTIFIER:
+        }
+        break;
+        case ParseState::STATE_EXPECT_VALUE:
+        {
+            option_type& option = m_sections->back().m_options.back();
+            if (t.type == detail::TokenType::TOKEN_VALUE)
             {
-                m_sections.back().m_options_map.emplace(
-                    std::string{ it->begin_ptr, (size_t)it->length },
-                    m_sections.back().m_options.size());
-
-                m_sections.back().m_options.emplace_back(
-                    std::string{ it->begin_ptr, (size_t)it->length });
-
-                const auto identifier_it = it++;
-                if (it == tokens.end())
+                if (!parse_value(option, t))
                 {
-                    m_error_code = ErrorCode::EXPECTING_VALUE_AFTER_IDENTIFIER;
-                    m_error_line = identifier_it->line;
-                    m_error_column = identifier_it->column;
                     return false;
                 }
 
-                values_vector& values = m_sections.back().m_options.back().m_values;
-                if (it->type == detail::TokenType::TOKEN_VALUE)
-                {
-                    parse_value(values, *it);
-                }
-                else if (it->type == detail::TokenType::TOKEN_VECTOR_VALUE)
-                {
-                    while ((it != tokens.end()) && (it->type == detail::TokenType::TOKEN_VECTOR_VALUE))
-                    {
-                        parse_value(values, *it);
-                        ++it;
-                    }
-
-                    --it;
-                }
-                else
+                m_parse_state = ParseState::STATE_SECTION;
+            }
+            else if (t.type == detail::TokenType::TOKEN_VECTOR_VALUE)
+            {
+                if (!parse_value(option, t))
                 {
-                    m_error_code = ErrorCode::EXPECTING_VALUE_AFTER_IDENTIFIER;
-                    m_error_line = identifier_it->line;
-                    m_error_column = identifier_it->column;
                     return false;
                 }
+
+                m_parse_state = ParseState::STATE_VECTOR_VALUE;
             }
-            break;
-            case detail::TokenType::TOKEN_VALUE:
-            case detail::TokenType::TOKEN_VECTOR_VALUE:
+            else
             {
-                m_error_code = ErrorCode::UNEXPECTED_VALUE;
-                m_error_line = it->line;
-                m_error_column = it->column;
+                set_error(ErrorCode::EXPECTING_VALUE_AFTER_IDENTIFIER,
+                    m_identifier_line, m_identifier_column);
                 return false;
             }
-            break;
-            default:
+
+            return true;
+        }
+        case ParseState::STATE_VECTOR_VALUE:
+        {
+            // consecutive vector values all belong
+            // to the last option
+            if (t.type == detail::TokenType::TOKEN_VECTOR_VALUE)
             {
-                m_error_code = ErrorCode::UNEXPECTED_TOKEN;
-                m_error_line = it->line;
-                m_error_column = it->column;
-                return false;
+                return parse_value(m_sections->back().m_options.back(), t);
             }
+
+            // the list is complete, its values
+            // can go into a column right away
+            m_sections->back().m_options.back().make_column();
+        }
+        break;
+        case ParseState::STATE_ERROR:
+            return false;
+        default:
             break;
+    }
+
+    switch (t.type)
+    {
+        case detail::TokenType::TOKEN_SECTION:
+        {
+            const std::string_view name = store_name({ t.begin_ptr, (size_t)t.length });
+
+            m_sections_map->emplace(name, m_sections->size());
+            m_sections->emplace_back(name);
+
+            m_parse_state = ParseState::STATE_SECTION;
+        }
+        break;
+        case detail::TokenType::TOKEN_IDENTIFIER:
+        {
+            const std::string_view name = store_name({ t.begin_ptr, (size_t)t.length });
+
+            m_sections->back().m_options_map.emplace(name, m_sections->back().m_options.size());
+            m_sections->back().m_options.emplace_back(name);
+
+            m_identifier_line = t.line;
+            m_identifier_column = t.column;
+            m_parse_state = ParseState::STATE_EXPECT_VALUE;
+        }
+        break;
+        case detail::TokenType::TOKEN_VALUE:
+        case detail::TokenType::TOKEN_VECTOR_VALUE:
+        {
+            set_error(ErrorCode::UNEXPECTED_VALUE, t.line, t.column);
+            return false;
+        }
+        break;
+        default:
+        {
+            set_error(ErrorCode::UNEXPECTED_TOKEN, t.line, t.column);
+            return false;
         }
+        break;
     }
 
     return true;
 }
 
-bool ConfigParser::parse_text(const char* text)
+bool ConfigParser::parse_end()
 {
-    m_sections.clear();
-    m_sections_map.clear();
+    if (m_parse_state == ParseState::STATE_EXPECT_VALUE)
+    {
+        set_error(ErrorCode::EXPECTING_VALUE_AFTER_IDENTIFIER,
+            m_identifier_line, m_identifier_column);
+    }
 
-    detail::tokenizer t;
-    m_error_code = t.parse(text);
+    if (m_parse_state == ParseState::STATE_ERROR)
+    {
+        return false;
+    }
 
-    if (m_error_code != ErrorCode::NO_ERROR)
+    if (m_parse_state == ParseState::STATE_VECTOR_VALUE)
     {
-        m_error_line = t.current_line();
-        m_error_column = t.current_column();
+        m_sections->back().m_options.back().make_column();
+    }
 
+    if (!resolve_links())
+    {
         return false;
     }
 
-    if (!t.tokens().empty())
+    make_columns();
+    return true;
+}
+
+void ConfigParser::make_columns()
+{
+    // lists with links are complete only once these are
+    // resolved, the others are in columns already
+    for (section_type& sct : *m_sections)
     {
-        return parse_tokens(t.tokens());
+        for (option_type& opt : sct.m_options)
+        {
+            opt.make_column();
+        }
     }
-
-    return m_error_code == ErrorCode::NO_ERROR;
 }
 
-bool ConfigParser::parse_file(const char* filename)
+bool ConfigParser::resolve_links()
 {
-    std::ifstream f(filename);
-    if (f.is_open())
+    struct link_node
     {
-        std::string str;
-        f.seekg(0, std::ios::end);
-        str.reserve(f.tellg());
-        f.seekg(0, std::ios::beg);
+        option_type* option;
+        size_t flat;
+        size_t begin; // of its links
+        size_t end;
+        size_t level;
+    }; // link_node
 
-        str.assign((std::istreambuf_iterator<char>(f)),
-            std::istreambuf_iterator<char>());
+    const std::vector<pending_link> pending(std::move(m_links));
+    m_links.clear();
 
-        return parse_text(str.c_str());
+    // every option gets a flat index, sections are numbered
+    // from the offset of their first option on
+    std::vector<size_t> offsets(m_sections->size() + 1, 0);
+    for (size_t i = 0; i < m_sections->size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + (*m_sections)[i].m_options.size();
     }
 
-    return false;
-}
+    // links of one option are recorded next to each other,
+    // together they form one node of the dependency graph
+    std::vector<link_node> nodes;
+    std::vector<option_type::value_link> links;
+    std::vector<size_t> targets; // flat option index, then node
+    std::vector<const pending_link*> origins;
+    links.reserve(pending.size());
+    targets.reserve(pending.size());
+    origins.reserve(pending.size());
 
-ErrorCode ConfigParser::error_code() const
-{
-    return m_error_code;
-}
+    // links tend to point into the same section
+    std::string_view last_name;
+    size_t last_idx = detail::perfect_hash::npos;
 
-int ConfigParser::get_error_line() const
-{
-    return m_error_line;
-}
+    for (const pending_link& link : pending)
+    {
+        if ((last_idx == detail::perfect_hash::npos) || (link.section_name != last_name))
+        {
+            const auto it = m_sections_map->find(link.section_name);
+            last_name = link.section_name;
+            last_idx = (it != m_sections_map->end()) ? it->second : detail::perfect_hash::npos;
+        }
 
-int ConfigParser::get_error_column() const
-{
-    return m_error_column;
-}
+        if (last_idx == detail::perfect_hash::npos)
+        {
+            continue;
+        }
 
-const section_vector& ConfigParser::sections() const
-{
-    return m_sections;
+        section_type& target_sct = (*m_sections)[last_idx];
+        const auto it = target_sct.m_options_map.find(link.option_name);
+        if (it == target_sct.m_options_map.end())
+        {
+            continue; // the link text stays as the value
+        }
+
+        option_type* option = &(*m_sections)[link.section_idx].m_options[link.option_idx];
+        if (nodes.empty() || (nodes.back().option != option))
+        {
+            const size_t flat = offsets[link.section_idx] + link.option_idx;
+            nodes.push_back({ option, flat, links.size(), links.size(), 0 });
+        }
+
+        links.push_back({ link.value_idx, &target_sct.m_options[it->second] });
+        targets.push_back(offsets[last_idx] + it->second);
+        origins.push_back(&link);
+        ++nodes.back().end;
+    }
+
+    if (nodes.empty())
+    {
+        return true;
+    }
+
+    std::vector<size_t> node_of(offsets.back(), detail::perfect_hash::npos);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        node_of[nodes[i].flat] = i;
+    }
+
+    for (size_t& target : targets)
+    {
+        target = node_of[target];
+    }
+
+    // depth first, a node is levelled once all of its targets are;
+    // the link reaching a node still on the stack closes a cycle
+    enum class Mark { NEW, ACTIVE, DONE };
+    std::vector<Mark> marks(nodes.size(), Mark::NEW);
+    std::vector<std::pair<size_t, size_t>> stack; // node, next link
+    size_t max_level = 0;
+
+    for (size_t root = 0; root < nodes.size(); ++root)
+    {
+        if (marks[root] != Mark::NEW)
+        {
+            continue;
+        }
+
+        marks[root] = Mark::ACTIVE;
+        stack.emplace_back(root, nodes[root].begin);
+        while (!stack.empty())
+        {
+            link_node& node = nodes[stack.back().first];
+            if (stack.back().second < node.end)
+            {
+                const size_t link = stack.back().second++;
+                const size_t target = targets[link];
+                if (target == detail::perfect_hash::npos)
+                {
+                    continue;
+                }
+
+                if (marks[target] == Mark::ACTIVE)
+                {
+                    set_error(ErrorCode::LINK_CYCLE, origins[link]->line, origins[link]->column);
+                    return false;
+                }
+
+                if (marks[target] == Mark::NEW)
+                {
+                    marks[target] = Mark::ACTIVE;
+                    stack.emplace_back(target, nodes[target].begin);
+                }
+
+                continue;
+            }
+
+            for (size_t i = node.begin; i < node.end; ++i)
+            {
+                if (targets[i] != detail::perfect_hash::npos)
+                {
+                    node.level = std::max(node.level, nodes[targets[i]].level + 1);
+                }
+            }
+
+            max_level = std::max(max_level, node.level);
+            marks[stack.back().first] = Mark::DONE;
+            stack.pop_back();
+        }
+    }
+
+    // nodes ordered by level, levels[l] is where level l starts
+    std::vector<size_t> levels(max_level + 2, 0);
+    for (const link_node& node : nodes)
+    {
+        ++levels[node.level + 1];
+    }
+
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        levels[l] += levels[l - 1];
+    }
+
+    std::vector<size_t> order(nodes.size());
+    std::vector<size_t> next(levels.begin(), levels.end() - 1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        order[next[nodes[i].level]++] = i;
+    }
+
+    // created for the first level large enough
+    std::optional<detail::thread_pool> pool;
+
+    for (size_t l = 0; l <= max_level; ++l)
+    {
+        const size_t* level = order.data() + levels[l];
+        const size_t count = levels[l + 1] - levels[l];
+
+        // the targets of a level are complete, sharing their values
+        // up front leaves only reads of them to the nodes below
+        for (size_t i = 0; i < count; ++i)
+        {
+            const link_node& node = nodes[level[i]];
+            for (size_t j = node.begin; j < node.end; ++j)
+            {
+                links[j].source->share_values();
+            }
+        }
+
+        const auto splice = [&nodes, &links, level](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const link_node& node = nodes[level[i]];
+                node.option->splice_links(links.data() + node.begin, node.end - node.begin);
+            }
+        };
+
+        if ((count >= PARALLEL_LINKS_MIN) && is_parallel())
+        {
+            if (!pool)
+            {
+                pool.emplace(m_thread_count);
+            }
+
+            run_chunks(*pool, count, splice);
+        }
+        else
+        {
+            splice(0, count);
+        }
+    }
+
+    return true;
+}
+
+bool ConfigParser::tokenize(const char* text, int& line, int& column, const char* end)
+{
+    // every token goes straight into the document; after a
+    // parser error the remaining tokens are dropped, but the
+    // text is still tokenized since a tokenizer error
+    // takes precedence over it
+    parser_sink sink(*this);
+
+    detail::tokenizer t;
+    const ErrorCode error_code = t.parse(text, end, sink, line, column);
+
+    line = t.current_line();
+    column = t.current_column();
+
+    if (error_code != ErrorCode::NO_ERROR)
+    {
+        set_error(error_code, line, column);
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigParser::parse_parallel(const char* text, size_t size)
+{
+    detail::thread_pool pool(m_thread_count);
+
+    // every part starts with a section header at the start of a
+    // line, so it can be parsed like a document of its own
+    std::vector<const char*> bounds{ text };
+    const size_t count = std::min(pool.size() * 4, size / PARALLEL_PART_MIN);
+    for (size_t i = 1; i < count; ++i)
+    {
+        const char* ptr = std::max(text + size * i / count, bounds.back());
+        while ((ptr = static_cast<const char*>(memchr(ptr, '\n', text + size - ptr))) != nullptr)
+        {
+            if (*(++ptr) == '[')
+            {
+                break;
+            }
+        }
+
+        if (ptr == nullptr)
+        {
+            break;
+        }
+
+        if (ptr != bounds.back())
+        {
+            bounds.push_back(ptr);
+        }
+    }
+
+    bounds.push_back(text + size);
+
+    const size_t parts_count = bounds.size() - 1;
+    std::vector<ConfigParser> parts(parts_count);
+    std::vector<int> lines(parts_count);
+    std::vector<char> tokenized(parts_count);
+
+    pool.run(parts_count, [&](size_t i) {
+        // parts are parsed on the heap, one thread each, and
+        // intern into the interner of the document
+        ConfigParser& part = parts[i];
+        part.copy_settings(*this);
+        part.m_memory_mode = MemoryMode::MEMORY_HEAP;
+        part.m_memory_resource = nullptr;
+        part.m_thread_count = 1;
+        part.m_intern_mode = (m_interner != nullptr) ? m_intern_mode : InternMode::INTERN_NONE;
+        part.m_shared_interner = m_interner;
+        part.m_defer_links = true; // an earlier part may have the same section
+        part.parse_begin();
+        part.m_borrow_text = m_borrow_text;
+
+        // lines are counted from the start of the part and moved
+        // afterwards; a line after the first one starts at column
+        // 2, as the tokenizer counts the newline itself
+        int line = 1;
+        int column = (i == 0) ? 1 : 2;
+        tokenized[i] = part.tokenize(bounds[i], line, column, bounds[i + 1]);
+        lines[i] = line - 1;
+    });
+
+    // the first tokenizer error takes precedence over
+    // any parser error, as it does for a single part
+    int line_offset = 0;
+    for (size_t i = 0; i < parts_count; ++i)
+    {
+        const ConfigParser& part = parts[i];
+        if (!tokenized[i])
+        {
+            set_error(part.m_error_code, part.m_error_line + line_offset, part.m_error_column);
+            return false;
+        }
+
+        line_offset += lines[i];
+    }
+
+    line_offset = 0;
+    for (size_t i = 0; i < parts_count; ++i)
+    {
+        const ConfigParser& part = parts[i];
+        if (part.m_parse_state == ParseState::STATE_ERROR)
+        {
+            set_error(part.m_error_code, part.m_error_line + line_offset, part.m_error_column);
+            return false;
+        }
+
+        // the section header of the next part ends the option
+        if ((part.m_parse_state == ParseState::STATE_EXPECT_VALUE) && (i + 1 < parts_count))
+        {
+            set_error(ErrorCode::EXPECTING_VALUE_AFTER_IDENTIFIER,
+                part.m_identifier_line + line_offset, part.m_identifier_column);
+            return false;
+        }
+
+        line_offset += lines[i];
+    }
+
+    // the parts are joined in source order, a section
+    // name is found at its first occurrence as before
+    line_offset = 0;
+    for (size_t i = 0; i < parts_count; ++i)
+    {
+        ConfigParser& part = parts[i];
+        for (pending_link link : part.m_links)
+        {
+            link.section_idx += m_sections->size();
+            link.line += line_offset;
+            m_links.push_back(link);
+        }
+
+        for (section_type& sct : *part.m_sections)
+        {
+            m_sections_map->emplace(sct.name(), m_sections->size());
+            m_sections->push_back(std::move(sct));
+        }
+
+        m_strings->adopt(*part.m_strings);
+
+        m_parse_state = part.m_parse_state;
+        m_identifier_line = part.m_identifier_line + line_offset;
+        m_identifier_column = part.m_identifier_column;
+
+        line_offset += lines[i];
+    }
+
+    return parse_end();
+}
+
+bool ConfigParser::reparse_chunks(const char* text)
+{
+    struct chunk
+    {
+        const char* begin;
+        const char* end;
+        int line;
+        size_t kept; // its record in the previous text
+        size_t part; // the part parsing it again
+        bool parse;
+    }; // chunk
+
+    struct part
+    {
+        size_t begin; // of its chunks
+        size_t end;
+        ConfigParser parser;
+        bool tokenized = false;
+    }; // part
+
+    constexpr size_t npos = detail::perfect_hash::npos;
+    const char* text_end = text + strlen(text);
+
+    // the first chunk holds the text before any section, every
+    // line starting with a section header starts another one
+    std::vector<chunk> chunks{ { text, nullptr, 1, npos, npos, true } };
+    int line = 1;
+    for (const char* ptr = text; ptr != nullptr; )
+    {
+        if (*ptr == '[')
+        {
+            chunks.push_back({ ptr, nullptr, line, npos, npos, true });
+        }
+
+        ptr = static_cast<const char*>(memchr(ptr, '\n', text_end - ptr));
+        if (ptr != nullptr)
+        {
+            ++ptr;
+            ++line;
+        }
+    }
+
+    std::vector<std::uint64_t> hashes(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].end = (i + 1 < chunks.size()) ? chunks[i + 1].begin : text_end;
+        hashes[i] = detail::hash_key({ chunks[i].begin, (size_t)(chunks[i].end - chunks[i].begin) });
+    }
+
+    // an unchanged chunk keeps its sections, only the text before
+    // any section is always parsed again; first_section maps the
+    // previous chunks to the index of their first section; the
+    // strings of a copy are shared, so nothing is added to them;
+    // the strings of replaced chunks stay until a full parse, which
+    // is done once they outweigh the ones still in use
+    size_t live_bytes = 0;
+    for (const chunk_record& record : m_records)
+    {
+        live_bytes += record.size;
+    }
+
+    const bool incremental = m_incremental && (m_strings.use_count() == 1) &&
+        (m_dead_bytes <= live_bytes);
+    std::vector<size_t> first_section;
+    if (incremental)
+    {
+        std::unordered_multimap<std::uint64_t, size_t> previous;
+        first_section.resize(m_records.size() + 1, 0);
+        for (size_t k = 0; k < m_records.size(); ++k)
+        {
+            previous.emplace(m_records[k].hash, k);
+            first_section[k + 1] = first_section[k] + m_records[k].sections;
+        }
+
+        std::vector<char> taken(m_records.size(), false);
+        for (size_t i = 1; i < chunks.size(); ++i)
+        {
+            const size_t size = chunks[i].end - chunks[i].begin;
+            const auto range = previous.equal_range(hashes[i]);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (!taken[it->second] && (it->second != 0) && (m_records[it->second].size == size))
+                {
+                    taken[it->second] = true;
+                    chunks[i].kept = it->second;
+                    chunks[i].parse = false;
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        parse_begin();
+    }
+
+    // consecutive changed chunks are parsed together into the
+    // same memory resource, so their sections can be moved
+    std::pmr::memory_resource* resource = m_sections->get_allocator().resource();
+    std::deque<part> parts;
+    std::optional<detail::thread_pool> pool;
+
+    const auto parse_parts = [&]() {
+        const size_t from = parts.size();
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (!chunks[i].parse || (chunks[i].part != npos))
+            {
+                continue;
+            }
+
+            // runs are split for threads like a whole text is
+            const bool split = (parts.size() > from) && is_parallel() &&
+                (chunks[i].begin - chunks[parts.back().begin].begin >= (std::ptrdiff_t)PARALLEL_PART_MIN);
+
+            if ((parts.size() == from) || (parts.back().end != i) || split)
+            {
+                parts.emplace_back();
+                parts.back().begin = i;
+            }
+
+            chunks[i].part = parts.size() - 1;
+            parts.back().end = i + 1;
+        }
+
+        const auto parse = [&](size_t idx) {
+            part& p = parts[idx];
+            // parts allocate from the resource of the document,
+            // one thread each, and intern into its interner
+            ConfigParser& parser = p.parser;
+            parser.copy_settings(*this);
+            parser.m_memory_mode = MemoryMode::MEMORY_HEAP;
+            parser.m_memory_resource = resource;
+            parser.m_thread_count = 1;
+            parser.m_intern_mode = (m_interner != nullptr) ? m_intern_mode : InternMode::INTERN_NONE;
+            parser.m_shared_interner = m_interner;
+            parser.m_defer_links = true; // may link to sections around it
+            parser.parse_begin();
+            parser.m_incremental = true;
+
+            p.tokenized = true;
+            for (size_t i = p.begin; i < p.end; ++i)
+            {
+                const chunk& c = chunks[i];
+                const size_t sections = parser.m_sections->size();
+                parser.m_records.push_back({ hashes[i], (size_t)(c.end - c.begin), 0, {} });
+
+                // a line after the first one starts at column 2,
+                // as the tokenizer counts the newline itself
+                if (p.tokenized && (c.begin != c.end))
+                {
+                    int line = c.line;
+                    int column = (c.begin == text) ? 1 : 2;
+                    p.tokenized = parser.tokenize(c.begin, line, column, c.end);
+                }
+
+                parser.m_records.back().sections = parser.m_sections->size() - sections;
+            }
+        };
+
+        const size_t count = parts.size() - from;
+        if ((count > 1) && is_parallel())
+        {
+            if (!pool)
+            {
+                pool.emplace(m_thread_count);
+            }
+
+            pool->run(count, [&](size_t i) { parse(from + i); });
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                parse(from + i);
+            }
+        }
+
+        // an unchanged chunk parses as it did before, so any
+        // error is in a changed one
+        for (size_t idx = from; idx < parts.size(); ++idx)
+        {
+            const part& p = parts[idx];
+            if (!p.tokenized ||
+                (p.parser.m_parse_state == ParseState::STATE_ERROR) ||
+                ((p.parser.m_parse_state == ParseState::STATE_EXPECT_VALUE) && (p.end != chunks.size())))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    if (!parse_parts())
+    {
+        return false;
+    }
+
+    if (incremental)
+    {
+        // where the sections of a chunk are now
+        struct chunk_sections
+        {
+            const section_vector* sections;
+            size_t begin;
+            size_t end;
+        }; // chunk_sections
+
+        const auto sections_of = [&](size_t i) -> chunk_sections {
+            const chunk& c = chunks[i];
+            if (c.part == npos)
+            {
+                const size_t begin = first_section[c.kept];
+                return { &*m_sections, begin, begin + m_records[c.kept].sections };
+            }
+
+            const part& p = parts[c.part];
+            size_t begin = 0;
+            for (size_t j = p.begin; j < i; ++j)
+            {
+                begin += p.parser.m_records[j - p.begin].sections;
+            }
+
+            return { &*p.parser.m_sections, begin, begin + p.parser.m_records[i - p.begin].sections };
+        };
+
+        std::unordered_map<std::string_view, size_t> first; // chunk of the first section
+        std::unordered_map<std::string_view, std::vector<size_t>> linking; // kept chunks
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            const chunk_sections cs = sections_of(i);
+            for (size_t j = cs.begin; j < cs.end; ++j)
+            {
+                first.emplace((*cs.sections)[j].name(), i);
+            }
+
+            if (!chunks[i].parse)
+            {
+                for (const std::string_view name : m_records[chunks[i].kept].links)
+                {
+                    linking[name].push_back(i);
+                }
+            }
+        }
+
+        // a kept chunk is parsed again once a name it links to
+        // finds a section parsed again, or another section
+        const auto is_stale = [&](std::string_view name) {
+            const auto it = first.find(name);
+            if ((it != first.end()) && chunks[it->second].parse)
+            {
+                return true;
+            }
+
+            const size_t now = (it != first.end()) ? chunks[it->second].kept : npos;
+            const size_t idx = find_section_index(name);
+            const size_t before = (idx != npos) ?
+                (size_t)(std::upper_bound(first_section.begin(), first_section.end(), idx) - first_section.begin() - 1) :
+                npos;
+
+            return now != before;
+        };
+
+        std::vector<size_t> stale;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (chunks[i].parse)
+            {
+                continue;
+            }
+
+            for (const std::string_view name : m_records[chunks[i].kept].links)
+            {
+                if (is_stale(name))
+                {
+                    chunks[i].parse = true;
+                    stale.push_back(i);
+                    break;
+                }
+            }
+        }
+
+        // and so are the chunks linking into those
+        while (!stale.empty())
+        {
+            const size_t i = stale.back();
+            stale.pop_back();
+
+            const chunk_sections cs = sections_of(i);
+            for (size_t j = cs.begin; j < cs.end; ++j)
+            {
+                const std::string_view name = (*cs.sections)[j].name();
+                const auto it = linking.find(name);
+                if ((it == linking.end()) || (first[name] != i))
+                {
+                    continue;
+                }
+
+                for (const size_t k : it->second)
+                {
+                    if (!chunks[k].parse)
+                    {
+                        chunks[k].parse = true;
+                        stale.push_back(k);
+                    }
+                }
+            }
+        }
+
+        if (!parse_parts())
+        {
+            return false;
+        }
+    }
+
+    // the document is put together in text order, from the
+    // kept sections and the parsed ones
+    section_vector sections(resource);
+    std::vector<chunk_record> records;
+    records.reserve(chunks.size());
+    size_t kept_bytes = 0;
+    m_links.clear();
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        const chunk& c = chunks[i];
+        if (!c.parse)
+        {
+            const size_t first = first_section[c.kept];
+            for (size_t j = 0; j < m_records[c.kept].sections; ++j)
+            {
+                sections.push_back(std::move((*m_sections)[first + j]));
+            }
+
+            kept_bytes += m_records[c.kept].size;
+            records.push_back(std::move(m_records[c.kept]));
+            m_parse_state = ParseState::STATE_SECTION;
+            continue;
+        }
+
+        part& p = parts[c.part];
+        if (p.begin != i)
+        {
+            continue;
+        }
+
+        ConfigParser& parser = p.parser;
+        for (pending_link link : parser.m_links)
+        {
+            link.section_idx += sections.size();
+            m_links.push_back(link);
+        }
+
+        for (section_type& sct : *parser.m_sections)
+        {
+            sections.push_back(std::move(sct));
+        }
+
+        for (chunk_record& record : parser.m_records)
+        {
+            records.push_back(std::move(record));
+        }
+
+        m_strings->adopt(*parser.m_strings);
+
+        m_parse_state = parser.m_parse_state;
+        m_identifier_line = parser.m_identifier_line;
+        m_identifier_column = parser.m_identifier_column;
+    }
+
+    m_sections.emplace(std::move(sections));
+    m_sections_map->clear();
+    for (size_t idx = 0; idx < m_sections->size(); ++idx)
+    {
+        m_sections_map->emplace((*m_sections)[idx].name(), idx);
+    }
+
+    if (incremental)
+    {
+        m_dead_bytes += live_bytes - kept_bytes;
+    }
+
+    m_sections_index->clear();
+    m_records = std::move(records);
+    m_generation = next_generation();
+    m_error_code = ErrorCode::NO_ERROR;
+
+    return parse_end();
+}
+
+bool ConfigParser::reparse_buffer(const char* text)
+{
+    // the new document is frozen like the previous one
+    const bool frozen = is_frozen();
+
+    if (reparse_chunks(text))
+    {
+        m_incremental = true;
+    }
+    else
+    {
+        // errors are reported like a single parse would,
+        // from a parse of the whole text
+        parse_begin();
+        if (!parse_buffer(text))
+        {
+            return false;
+        }
+    }
+
+    if (frozen)
+    {
+        freeze();
+    }
+
+    return true;
+}
+
+bool ConfigParser::parse_buffer(const char* text)
+{
+    if (is_parallel())
+    {
+        const size_t size = strlen(text);
+        if (size >= PARALLEL_PARSE_MIN)
+        {
+            return parse_parallel(text, size);
+        }
+    }
+
+    int line = 1;
+    int column = 1;
+    if (!tokenize(text, line, column))
+    {
+        return false;
+    }
+
+    return parse_end();
+}
+
+void ConfigParser::set_document_mode(DocumentMode mode)
+{
+    m_document_mode = mode;
+}
+
+DocumentMode ConfigParser::document_mode() const
+{
+    return m_document_mode;
+}
+
+void ConfigParser::set_value_mode(ValueMode mode)
+{
+    m_value_mode = mode;
+}
+
+ValueMode ConfigParser::value_mode() const
+{
+    return m_value_mode;
+}
+
+void ConfigParser::set_number_mode(NumberMode mode)
+{
+    m_number_mode = mode;
+}
+
+NumberMode ConfigParser::number_mode() const
+{
+    return m_number_mode;
+}
+
+void ConfigParser::set_intern_mode(InternMode mode)
+{
+    m_intern_mode = mode;
+}
+
+InternMode ConfigParser::intern_mode() const
+{
+    return m_intern_mode;
+}
+
+void ConfigParser::set_interner(std::shared_ptr<string_interner> interner)
+{
+    m_shared_interner = std::move(interner);
+}
+
+const std::shared_ptr<string_interner>& ConfigParser::interner() const
+{
+    return m_shared_interner;
+}
+
+void ConfigParser::add_boolean_word(std::string_view word, bool value)
+{
+    m_boolean_words = detail::add_boolean_word(m_boolean_words, word, value);
+}
+
+void ConfigParser::clear_boolean_words()
+{
+    m_boolean_words.reset();
+}
+
+void ConfigParser::set_boolean_words(std::shared_ptr<const detail::boolean_words> words)
+{
+    m_boolean_words = std::move(words);
+}
+
+const std::shared_ptr<const detail::boolean_words>& ConfigParser::boolean_words() const
+{
+    return m_boolean_words;
+}
+
+void ConfigParser::set_thread_count(unsigned count)
+{
+    m_thread_count = count;
+}
+
+unsigned ConfigParser::thread_count() const
+{
+    return m_thread_count;
+}
+
+void ConfigParser::set_memory_mode(MemoryMode mode)
+{
+    m_memory_mode = mode;
+}
+
+MemoryMode ConfigParser::memory_mode() const
+{
+    return m_memory_mode;
+}
+
+void ConfigParser::set_memory_resource(std::pmr::memory_resource* resource)
+{
+    m_memory_resource = resource;
+}
+
+std::pmr::memory_resource* ConfigParser::memory_resource() const
+{
+    return m_memory_resource;
+}
+
+bool ConfigParser::parse_text(const char* text)
+{
+    if (m_document_mode == DocumentMode::DOCUMENT_VIEW)
+    {
+        return parse_text(std::string{ text });
+    }
+
+    parse_begin();
+    return parse_buffer(text);
+}
+
+bool ConfigParser::parse_text(std::string&& text)
+{
+    if (m_document_mode != DocumentMode::DOCUMENT_VIEW)
+    {
+        return parse_text(text.c_str());
+    }
+
+    auto owner = std::make_shared<std::string>(std::move(text));
+
+    parse_begin();
+    m_text_owner = owner;
+    m_borrow_text = true;
+
+    return parse_buffer(owner->c_str());
+}
+
+bool ConfigParser::reparse_text(const char* text)
+{
+    return reparse_buffer(text);
+}
+
+bool ConfigParser::reparse_file(const char* filename)
+{
+    // the text is not kept, parsed sections are copied
+    detail::mapped_file f;
+    if (f.open(filename))
+    {
+        return reparse_buffer(f.data());
+    }
+
+    std::ifstream stream(filename);
+    if (stream.is_open())
+    {
+        std::string str;
+        if (!read_stream(stream, str))
+        {
+            return read_failed();
+        }
+
+        return reparse_buffer(str.c_str());
+    }
+
+    return read_failed();
+}
+
+void ConfigParser::feed_begin()
+{
+    parse_begin();
+
+    m_feed_buffer.clear();
+    m_feed_line = 1;
+    m_feed_column = 1;
+    m_feed_stopped = false;
+}
+
+bool ConfigParser::feed_lines(size_t appended, bool last)
+{
+    // text is NUL terminated, so anything after a NUL
+    // character is ignored, like parse_text() does
+    if (!m_feed_stopped && (appended > 0))
+    {
+        const size_t offset = m_feed_buffer.size() - appended;
+        const size_t nul_pos = m_feed_buffer.find('\0', offset);
+        if (nul_pos != std::string::npos)
+        {
+            m_feed_buffer.resize(nul_pos);
+            m_feed_stopped = true;
+        }
+    }
+
+    // tokens never span multiple lines, so all complete
+    // lines can be parsed and only the last, incomplete
+    // one has to be carried over to the next chunk
+    size_t end = m_feed_buffer.size();
+    if (!last && !m_feed_stopped)
+    {
+        end = m_feed_buffer.rfind('\n');
+        if (end == std::string::npos)
+        {
+            return true;
+        }
+
+        ++end;
+    }
+
+    if (end == 0)
+    {
+        return true;
+    }
+
+    // temporarily terminate the complete lines, the tokens
+    // are consumed before the buffer is touched again
+    const char saved = m_feed_buffer[end];
+    m_feed_buffer[end] = 0;
+
+    const bool tokenized = tokenize(m_feed_buffer.data(), m_feed_line, m_feed_column);
+
+    m_feed_buffer[end] = saved;
+
+    if (!tokenized)
+    {
+        m_feed_buffer.clear();
+        m_feed_stopped = true;
+        return false;
+    }
+
+    m_feed_buffer.erase(0, end);
+    return true;
+}
+
+bool ConfigParser::feed(const char* data, size_t size)
+{
+    if (!m_feed_stopped)
+    {
+        m_feed_buffer.append(data, size);
+        feed_lines(size, false);
+    }
+
+    return m_error_code == ErrorCode::NO_ERROR;
+}
+
+bool ConfigParser::feed_end()
+{
+    if (!feed_lines(0, true))
+    {
+        return false;
+    }
+
+    return parse_end();
+}
+
+bool ConfigParser::parse_stream(std::istream& stream, size_t chunk_size)
+{
+    feed_begin();
+
+    // read straight into the carried over buffer
+    // to avoid copying every chunk twice
+    while (!m_feed_stopped && stream)
+    {
+        const size_t size = m_feed_buffer.size();
+        m_feed_buffer.resize(size + chunk_size);
+        stream.read(&m_feed_buffer[size], (std::streamsize)chunk_size);
+
+        const size_t read_size = (size_t)stream.gcount();
+        m_feed_buffer.resize(size + read_size);
+
+        if (!feed_lines(read_size, false))
+        {
+            return false;
+        }
+    }
+
+    if (stream.bad())
+    {
+        return read_failed();
+    }
+
+    return feed_end();
+}
+
+bool ConfigParser::parse_fd(int fd, size_t chunk_size)
+{
+    feed_begin();
+
+    while (!m_feed_stopped)
+    {
+        const size_t size = m_feed_buffer.size();
+        m_feed_buffer.resize(size + chunk_size);
+
+        const std::ptrdiff_t read_size = read_fd(fd, &m_feed_buffer[size], chunk_size);
+        if (read_size < 0)
+        {
+            if (errno == EINTR)
+            {
+                m_feed_buffer.resize(size);
+                continue;
+            }
+
+            m_feed_buffer.clear();
+            m_feed_stopped = true;
+            return read_failed();
+        }
+
+        m_feed_buffer.resize(size + (size_t)read_size);
+        if (read_size == 0)
+        {
+            break;
+        }
+
+        if (!feed_lines((size_t)read_size, false))
+        {
+            return false;
+        }
+    }
+
+    return feed_end();
+}
+
+bool ConfigParser::parse_stream_file(const char* filename)
+{
+    std::ifstream f(filename);
+    if (f.is_open())
+    {
+        std::string str;
+        if (!read_stream(f, str))
+        {
+            return read_failed();
+        }
+
+        return parse_text(std::move(str));
+    }
+
+    return read_failed();
+}
+
+bool ConfigParser::parse_file(const char* filename, LoadMode mode)
+{
+    if (mode == LoadMode::LOAD_MMAP)
+    {
+        // the mapping is released once parsing is done, unless
+        // the document borrows its strings from it
+        auto f = std::make_shared<detail::mapped_file>();
+        if (f->open(filename))
+        {
+            if (m_document_mode != DocumentMode::DOCUMENT_VIEW)
+            {
+                return parse_text(f->data());
+            }
+
+            parse_begin();
+            m_text_owner = f;
+            m_borrow_text = true;
+
+            return parse_buffer(f->data());
+        }
+    }
+
+    return parse_stream_file(filename);
+}
+
+ErrorCode ConfigParser::error_code() const
+{
+    return m_error_code;
+}
+
+int ConfigParser::get_error_line() const
+{
+    return m_error_line;
+}
+
+int ConfigParser::get_error_column() const
+{
+    return m_error_column;
+}
+
+void ConfigParser::freeze()
+{
+    for (section_type& sct : *m_sections)
+    {
+        sct.freeze();
+    }
+
+    m_sections_index->build(*m_sections_map);
+}
+
+bool ConfigParser::is_frozen() const noexcept
+{
+    // false for a moved from parser as well
+    return m_sections_index.has_value() && m_sections_index->is_built();
+}
+
+const section_vector& ConfigParser::sections() const
+{
+    return *m_sections;
+}
+
+const section_type& ConfigParser::get_section(std::string_view section_name) const
+{
+    const section_type* sct = find_section(section_name);
+    if (sct == nullptr)
+    {
+        throw std::out_of_range("configparser: no such section");
+    }
+
+    return *sct;
+}
+
+const option_vector& ConfigParser::options(std::string_view section_name) const
+{
+    return get_section(section_name).options();
+}
+
+const option_type& ConfigParser::option(std::string_view section_name, std::string_view option_name) const
+{
+    return get_section(section_name).option(option_name);
+}
+
+size_t ConfigParser::find_section_index(std::string_view section_name) const noexcept
+{
+    if (m_sections_index->is_built())
+    {
+        return m_sections_index->find(section_name);
+    }
+
+    const auto it = m_sections_map->find(section_name);
+    return (it != m_sections_map->end()) ? it->second : detail::perfect_hash::npos;
+}
+
+size_t ConfigParser::find_section_index(std::string_view section_name, std::uint64_t hash) const noexcept
+{
+    if (m_sections_index->is_built())
+    {
+        return m_sections_index->find(section_name, hash);
+    }
+
+    return find_section_index(section_name);
+}
+
+const section_type* ConfigParser::find_section(std::string_view section_name) const noexcept
+{
+    const size_t idx = find_section_index(section_name);
+    return (idx != detail::perfect_hash::npos) ? &(*m_sections)[idx] : nullptr;
+}
+
+const option_type* ConfigParser::find_option(std::string_view section_name, std::string_view option_name) const noexcept
+{
+    const section_type* sct = find_section(section_name);
+    return (sct != nullptr) ? sct->find_option(option_name) : nullptr;
+}
+
+bool ConfigParser::has_section(std::string_view section_name) const noexcept
+{
+    return find_section(section_name) != nullptr;
+}
+
+bool ConfigParser::has_option(std::string_view section_name, std::string_view option_name) const noexcept
+{
+    return find_option(section_name, option_name) != nullptr;
+}
+
+option_handle ConfigParser::resolve(std::string_view section_name, std::string_view option_name) const noexcept
+{
+    return resolve(option_key(section_name, option_name));
+}
+
+option_handle ConfigParser::resolve(const option_key& key) const noexcept
+{
+    const size_t section_idx = find_section_index(key.section_name(), key.section_hash());
+    if (section_idx == detail::perfect_hash::npos)
+    {
+        return {};
+    }
+
+    const section_type& sct = (*m_sections)[section_idx];
+    const size_t option_idx = sct.find_index(key.option_name(), key.option_hash());
+    if (option_idx == detail::perfect_hash::npos)
+    {
+        return {};
+    }
+
+    return { section_idx, option_idx, m_generation };
 }
 
-const option_vector& ConfigParser::options(const std::string& section_name) const
+bool ConfigParser::is_valid(const option_handle& handle) const noexcept
 {
-    return m_sections[m_sections_map.at(section_name)].options();
+    return (handle.m_generation != 0) &&
+        (handle.m_generation == m_generation);
 }
 
-const option_type& ConfigParser::option(const std::string& section_name, const std::string& option_name) const
+const option_type& ConfigParser::option(const option_handle& handle) const
 {
-    return m_sections[m_sections_map.at(section_name)].option(option_name);
+    assert(is_valid(handle));
+    return (*m_sections)[handle.m_section_idx].m_options[handle.m_option_idx];
 }
 
-bool ConfigParser::has_section(const std::string& section_name) const
+const option_type* ConfigParser::find_option(const option_handle& handle) const noexcept
 {
-    return m_sections_map.find(section_name) != m_sections_map.end();
+    return is_valid(handle) ? &option(handle) : nullptr;
 }
 
-bool ConfigParser::has_option(const std::string& section_name, const std::string& option_name) const
+const option_type* ConfigParser::find_option(const option_key& key) const noexcept
 {
-    const auto it = m_sections_map.find(section_name);
-    return ((it != m_sections_map.end())) &&
-        (m_sections[it->second].has_option(option_name));
+    return find_option(resolve(key));
 }
 
 } // configparser
@@ -0,0 +1,157 @@
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CP_HAS_MMAP 1
+#include <fcntl.h> // open, posix_fadvise
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close, sysconf
+#endif
+
+namespace configparser
+{
+namespace detail
+{
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : m_address(other.m_address)
+    , m_mapped_length(other.m_mapped_length)
+    , m_size(other.m_size)
+    , m_open(other.m_open)
+{
+    other.m_address = nullptr;
+    other.m_mapped_length = 0;
+    other.m_size = 0;
+    other.m_open = false;
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+
+        m_address = other.m_address;
+        m_mapped_length = other.m_mapped_length;
+        m_size = other.m_size;
+        m_open = other.m_open;
+
+        other.m_address = nullptr;
+        other.m_mapped_length = 0;
+        other.m_size = 0;
+        other.m_open = false;
+    }
+
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+bool mapped_file::open(const char* filename)
+{
+    close();
+
+#ifdef CP_HAS_MMAP
+    const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // only regular files can be mapped, anything
+    // else (pipes, character devices) must be read
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_size = (std::size_t)st.st_size;
+    if (m_size == 0)
+    {
+        // nothing to map, data() points to an empty string
+        ::close(fd);
+        m_open = true;
+        return true;
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // reserve one byte more than the file size, rounded up to
+    // whole pages, as anonymous (zero filled) memory and map the
+    // file over its beginning; the byte after the file is either
+    // the zero filled tail of the last file page or part of the
+    // anonymous page, so the text is always NUL terminated
+    const std::size_t page_size = (std::size_t)sysconf(_SC_PAGESIZE);
+    m_mapped_length = ((m_size + 1 + page_size - 1) / page_size) * page_size;
+
+    m_address = mmap(nullptr, m_mapped_length, PROT_READ,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m_address == MAP_FAILED)
+    {
+        m_address = nullptr;
+        ::close(fd);
+        return false;
+    }
+
+    if (mmap(m_address, m_size, PROT_READ,
+        MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        ::close(fd);
+        close();
+        return false;
+    }
+
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+
+#if defined(MADV_SEQUENTIAL)
+    madvise(m_address, m_size, MADV_SEQUENTIAL);
+#endif
+
+    m_open = true;
+    return true;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+void mapped_file::close()
+{
+#ifdef CP_HAS_MMAP
+    if (m_address != nullptr)
+    {
+        munmap(m_address, m_mapped_length);
+    }
+#endif
+
+    m_address = nullptr;
+    m_mapped_length = 0;
+    m_size = 0;
+    m_open = false;
+}
+
+bool mapped_file::is_open() const
+{
+    return m_open;
+}
+
+const char* mapped_file::data() const
+{
+    return (m_address != nullptr) ? static_cast<const char*>(m_address) : "";
+}
+
+std::size_t mapped_file::size() const
+{
+    return m_size;
+}
+
+} // detail
+} // configparser
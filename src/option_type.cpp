@@ -1,44 +1,133 @@
 #include "option_type.h"
+#include <algorithm> // copy_n, min
+#include <cassert> // assert
+#include <memory> // allocate_shared
 
 namespace configparser
 {
 
-option_type::option_type(std::string&& name) noexcept
-    : m_name(std::move(name))
+option_type::option_type(std::string_view name) noexcept
+    : m_name(name)
 {
 }
 
+option_type::option_type(std::string_view name, const allocator_type& alloc) noexcept
+    : m_name(name)
+    , m_values(alloc)
+{
+}
+
+option_type::option_type(const option_type& other)
+    : m_name(other.m_name)
+{
+    *this = other;
+}
+
+option_type::option_type(const option_type& other, const allocator_type& alloc)
+    : m_name(other.m_name)
+    , m_values(alloc)
+{
+    *this = other;
+}
+
+option_type::option_type(option_type&& other, const allocator_type& alloc)
+    : m_name(other.m_name)
+    , m_values(std::move(other.m_values), alloc)
+    , m_shared_values(std::move(other.m_shared_values))
+    , m_column(std::move(other.m_column))
+{
+}
+
+option_type& option_type::operator=(const option_type& other)
+{
+    if (this != &other)
+    {
+        // copies never share values, so they do not depend
+        // on the memory of the document they came from
+        m_name = other.m_name;
+        m_shared_values.reset();
+
+        if (other.m_column)
+        {
+            m_column = other.m_column->copy(m_values.get_allocator().resource());
+            m_values.clear();
+        }
+        else
+        {
+            m_column.reset();
+            m_values = other.values();
+        }
+    }
+
+    return *this;
+}
+
 template <>
 long option_type::get<long>(size_t idx) const
 {
-    return m_values[idx].to_long();
+    if (m_column)
+    {
+        assert(m_column->type() == ValueType::VALUE_LONG);
+        return m_column->longs()[idx];
+    }
+
+    return values()[idx].to_long();
 }
 
 template <>
 double option_type::get<double>(size_t idx) const
 {
-    return m_values[idx].to_double();
+    if (m_column)
+    {
+        assert(m_column->type() == ValueType::VALUE_DOUBLE);
+        return m_column->doubles()[idx];
+    }
+
+    return values()[idx].to_double();
 }
 
 template <>
 bool option_type::get<bool>(size_t idx) const
 {
-    return m_values[idx].to_bool();
+    if (m_column)
+    {
+        assert(m_column->type() == ValueType::VALUE_BOOLEAN);
+        return m_column->bit(idx);
+    }
+
+    return values()[idx].to_bool();
 }
 
 template <>
 const std::string& option_type::get<const std::string&>(size_t idx) const
 {
-    return m_values[idx].to_str();
+    return values()[idx].to_str();
+}
+
+template <>
+std::string_view option_type::get<std::string_view>(size_t idx) const
+{
+    return values()[idx].to_view();
 }
 
 template <>
 bool option_type::get<long>(size_t idx, long& val) const
 {
-    if ((idx < m_values.size()) &&
-        (m_values[idx].has_type(ValueType::VALUE_LONG)))
+    if (m_column)
     {
-        val = m_values[idx].to_long();
+        if ((idx < m_column->size()) && (m_column->type() == ValueType::VALUE_LONG))
+        {
+            val = m_column->longs()[idx];
+            return true;
+        }
+
+        return false;
+    }
+
+    if ((idx < values().size()) &&
+        (values()[idx].has_type(ValueType::VALUE_LONG)))
+    {
+        val = values()[idx].to_long();
         return true;
     }
 
@@ -48,10 +137,21 @@ bool option_type::get<long>(size_t idx, long& val) const
 template <>
 bool option_type::get<double>(size_t idx, double& val) const
 {
-    if ((idx < m_values.size()) &&
-        (m_values[idx].has_type(ValueType::VALUE_DOUBLE)))
+    if (m_column)
+    {
+        if ((idx < m_column->size()) && (m_column->type() == ValueType::VALUE_DOUBLE))
+        {
+            val = m_column->doubles()[idx];
+            return true;
+        }
+
+        return false;
+    }
+
+    if ((idx < values().size()) &&
+        (values()[idx].has_type(ValueType::VALUE_DOUBLE)))
     {
-        val = m_values[idx].to_double();
+        val = values()[idx].to_double();
         return true;
     }
 
@@ -61,10 +161,21 @@ bool option_type::get<double>(size_t idx, double& val) const
 template <>
 bool option_type::get<bool>(size_t idx, bool& val) const
 {
-    if ((idx < m_values.size()) &&
-        (m_values[idx].has_type(ValueType::VALUE_BOOLEAN)))
+    if (m_column)
+    {
+        if ((idx < m_column->size()) && (m_column->type() == ValueType::VALUE_BOOLEAN))
+        {
+            val = m_column->bit(idx);
+            return true;
+        }
+
+        return false;
+    }
+
+    if ((idx < values().size()) &&
+        (values()[idx].has_type(ValueType::VALUE_BOOLEAN)))
     {
-        val = m_values[idx].to_bool();
+        val = values()[idx].to_bool();
         return true;
     }
 
@@ -74,10 +185,24 @@ bool option_type::get<bool>(size_t idx, bool& val) const
 template <>
 bool option_type::get<std::string>(size_t idx, std::string& val) const
 {
-    if ((idx < m_values.size()) &&
-        (m_values[idx].has_type(ValueType::VALUE_STRING)))
+    if ((idx < values().size()) &&
+        (values()[idx].has_type(ValueType::VALUE_STRING)))
+    {
+        // borrowed strings have no std::string to copy
+        val.assign(values()[idx].to_view());
+        return true;
+    }
+
+    return false;
+}
+
+template <>
+bool option_type::get<std::string_view>(size_t idx, std::string_view& val) const
+{
+    if ((idx < values().size()) &&
+        (values()[idx].has_type(ValueType::VALUE_STRING)))
     {
-        val = m_values[idx].to_str();
+        val = values()[idx].to_view();
         return true;
     }
 
@@ -91,7 +216,13 @@ ValueType option_type::get_type() const
 
 ValueType option_type::get_type(size_t idx) const
 {
-    return m_values[idx].type();
+    if (m_column)
+    {
+        assert(idx < m_column->size());
+        return m_column->type();
+    }
+
+    return values()[idx].type();
 }
 
 bool option_type::is_type(ValueType type) const
@@ -144,22 +275,244 @@ const std::string& option_type::get_str(size_t idx) const
     return get<const std::string&>(idx);
 }
 
+std::string_view option_type::get_view() const
+{
+    return get<std::string_view>();
+}
+
+std::string_view option_type::get_view(size_t idx) const
+{
+    return get<std::string_view>(idx);
+}
+
 size_t option_type::size() const
 {
-    return m_values.size();
+    return m_column ? m_column->size() : values().size();
 }
 
 bool option_type::is_vector() const
 {
-    return (m_values.size() > 1);
+    return (size() > 1);
+}
+
+bool option_type::is_column() const
+{
+    return (m_column != nullptr);
+}
+
+template <>
+span<const long> option_type::get_column<long>() const
+{
+    return m_column ? m_column->longs() : span<const long>();
+}
+
+template <>
+span<const double> option_type::get_column<double>() const
+{
+    return m_column ? m_column->doubles() : span<const double>();
+}
+
+span<const std::uint64_t> option_type::get_column_bits() const
+{
+    return m_column ? m_column->bits() : span<const std::uint64_t>();
+}
+
+namespace
+{
+    constexpr ValueType type_of(long) { return ValueType::VALUE_LONG; }
+    constexpr ValueType type_of(double) { return ValueType::VALUE_DOUBLE; }
+    constexpr ValueType type_of(bool) { return ValueType::VALUE_BOOLEAN; }
+
+    long value_of(const value_type& val, long) { return val.to_long(); }
+    double value_of(const value_type& val, double) { return val.to_double(); }
+    bool value_of(const value_type& val, bool) { return val.to_bool(); }
+
+    void copy_column(const detail::value_column& column, size_t first, size_t count, long* out)
+    {
+        std::copy_n(column.longs().data() + first, count, out);
+    }
+
+    void copy_column(const detail::value_column& column, size_t first, size_t count, double* out)
+    {
+        std::copy_n(column.doubles().data() + first, count, out);
+    }
+
+    void copy_column(const detail::value_column& column, size_t first, size_t count, bool* out)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = column.bit(first + i);
+        }
+    }
+
+    // either column or values is set
+    template <typename T>
+    size_t extract_values(const detail::value_column* column, const values_vector* values,
+        span<T> out, std::vector<size_t>* failed, size_t first)
+    {
+        const size_t size = column ? column->size() : values->size();
+        const size_t count = (first < size) ? std::min(out.size(), size - first) : 0;
+
+        // a column has one type for all of its values
+        if (column)
+        {
+            if (column->type() == type_of(T()))
+            {
+                copy_column(*column, first, count, out.data());
+                return count;
+            }
+
+            for (size_t i = 0; (failed != nullptr) && (i < count); ++i)
+            {
+                failed->push_back(first + i);
+            }
+
+            return 0;
+        }
+
+        size_t copied = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const value_type& val = (*values)[first + i];
+            if (val.type() == type_of(T()))
+            {
+                out[i] = value_of(val, T());
+                ++copied;
+            }
+            else if (failed != nullptr)
+            {
+                failed->push_back(first + i);
+            }
+        }
+
+        return copied;
+    }
+} // anonymous
+
+template <>
+size_t option_type::extract<long>(span<long> out, std::vector<size_t>* failed, size_t first) const
+{
+    return extract_values(m_column.get(), m_column ? nullptr : &values(), out, failed, first);
+}
+
+template <>
+size_t option_type::extract<double>(span<double> out, std::vector<size_t>* failed, size_t first) const
+{
+    return extract_values(m_column.get(), m_column ? nullptr : &values(), out, failed, first);
+}
+
+template <>
+size_t option_type::extract<bool>(span<bool> out, std::vector<size_t>* failed, size_t first) const
+{
+    return extract_values(m_column.get(), m_column ? nullptr : &values(), out, failed, first);
 }
 
 const values_vector& option_type::values() const
 {
+    if (m_column)
+    {
+        return m_column->values();
+    }
+
+    return m_shared_values ? *m_shared_values : m_values;
+}
+
+void option_type::make_column()
+{
+    // shared values stay as they are, their
+    // options may still be linked to
+    if (m_column || m_shared_values || (m_values.size() < 2))
+    {
+        return;
+    }
+
+    m_column = detail::value_column::build(m_values, m_values.get_allocator().resource());
+    if (m_column)
+    {
+        m_values.clear();
+        m_values.shrink_to_fit();
+    }
+}
+
+void option_type::drop_column()
+{
+    if (m_column)
+    {
+        const values_vector& values = m_column->values();
+        m_values.assign(values.begin(), values.end());
+        m_column.reset();
+    }
+}
+
+values_vector& option_type::own_values()
+{
+    drop_column();
+
+    // copy on write, only the option linking to shared
+    // values is changed afterwards
+    if (m_shared_values)
+    {
+        m_values.assign(m_shared_values->begin(), m_shared_values->end());
+        m_shared_values.reset();
+    }
+
     return m_values;
 }
 
-const std::string& option_type::name() const
+std::shared_ptr<const values_vector> option_type::share_values()
+{
+    drop_column();
+
+    if (!m_shared_values)
+    {
+        const std::pmr::polymorphic_allocator<values_vector> alloc(m_values.get_allocator().resource());
+        m_shared_values = std::allocate_shared<values_vector>(alloc, std::move(m_values));
+        m_values.clear();
+    }
+
+    return m_shared_values;
+}
+
+void option_type::link_values(option_type& source)
+{
+    // keeps the values alive even if this
+    // option is the source and stops sharing
+    const std::shared_ptr<const values_vector> shared = source.share_values();
+
+    if (!m_shared_values && m_values.empty())
+    {
+        m_shared_values = shared;
+        return;
+    }
+
+    values_vector& values = own_values();
+    values.insert(values.end(), shared->begin(), shared->end());
+}
+
+void option_type::splice_links(const value_link* links, size_t count)
+{
+    values_vector values(std::move(own_values()));
+    m_values.clear();
+
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (; next < links[i].position; ++next)
+        {
+            own_values().push_back(std::move(values[next]));
+        }
+
+        link_values(*links[i].source);
+        ++next; // the link text
+    }
+
+    for (; next < values.size(); ++next)
+    {
+        own_values().push_back(std::move(values[next]));
+    }
+}
+
+std::string_view option_type::name() const
 {
     return m_name;
 }
@@ -0,0 +1,170 @@
+#include "parallel.h"
+#include <algorithm> // max
+
+namespace configparser
+{
+namespace detail
+{
+
+unsigned effective_thread_count(unsigned thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::thread::hardware_concurrency();
+    }
+
+    return std::max(thread_count, 1u);
+}
+
+thread_pool::thread_pool(unsigned thread_count)
+{
+    const size_t size = effective_thread_count(thread_count);
+    for (size_t i = 0; i < size; ++i)
+    {
+        m_queues.push_back(std::make_unique<queue>());
+    }
+
+    m_threads.reserve(size - 1);
+    for (size_t i = 1; i < size; ++i)
+    {
+        m_threads.emplace_back(&thread_pool::worker_main, this, i);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+size_t thread_pool::size() const noexcept
+{
+    return m_queues.size();
+}
+
+bool thread_pool::pop(size_t self, size_t& task)
+{
+    // own tasks from the front, in the order they were
+    // dealt, stolen ones from the back of another queue
+    for (size_t i = 0; i < m_queues.size(); ++i)
+    {
+        queue& q = *m_queues[(self + i) % m_queues.size()];
+
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty())
+        {
+            if (i == 0)
+            {
+                task = q.tasks.front();
+                q.tasks.pop_front();
+            }
+            else
+            {
+                task = q.tasks.back();
+                q.tasks.pop_back();
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void thread_pool::work(size_t self)
+{
+    size_t task;
+    while (pop(self, task))
+    {
+        try
+        {
+            (*m_task)(task);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error)
+            {
+                m_error = std::current_exception();
+            }
+        }
+
+        if (--m_pending == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+void thread_pool::worker_main(size_t self)
+{
+    size_t batch = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, batch] { return m_stop || (m_batch != batch); });
+            if (m_stop)
+            {
+                return;
+            }
+
+            batch = m_batch;
+        }
+
+        work(self);
+    }
+}
+
+void thread_pool::run(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(m_run_mutex);
+
+    m_task = &task;
+    m_error = nullptr;
+    m_pending = count;
+
+    // dealt round robin, so the first tasks
+    // of the batch are started first
+    for (size_t i = 0; i < count; ++i)
+    {
+        queue& q = *m_queues[i % m_queues.size()];
+
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_batch;
+    }
+
+    m_wake.notify_all();
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_task = nullptr;
+
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+} // detail
+} // configparser
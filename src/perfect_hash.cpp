@@ -0,0 +1,176 @@
+#include "perfect_hash.h"
+#include <algorithm> // sort
+
+namespace configparser
+{
+namespace detail
+{
+
+namespace
+{
+    // buckets hold two keys on average, which keeps
+    // the search for displacements short
+    constexpr std::size_t KEYS_PER_BUCKET = 2;
+    constexpr std::uint32_t MAX_DISPLACEMENT = 1u << 24;
+} // anonymous
+
+perfect_hash::perfect_hash(const allocator_type& alloc)
+    : m_entries(alloc)
+    , m_displacements(alloc)
+{
+}
+
+perfect_hash::perfect_hash(const perfect_hash& other, const allocator_type& alloc)
+    : m_entries(other.m_entries, alloc)
+    , m_displacements(other.m_displacements, alloc)
+    , m_built(other.m_built)
+{
+}
+
+perfect_hash::perfect_hash(perfect_hash&& other, const allocator_type& alloc)
+    : m_entries(std::move(other.m_entries), alloc)
+    , m_displacements(std::move(other.m_displacements), alloc)
+    , m_built(other.m_built)
+{
+}
+
+std::uint32_t perfect_hash::reduce(std::uint64_t hash, std::size_t size) noexcept
+{
+    // maps the upper bits to [0, size) without a division
+    return (std::uint32_t)(((hash >> 32) * (std::uint64_t)size) >> 32);
+}
+
+std::size_t perfect_hash::slot(std::uint64_t hash, std::uint32_t displacement, std::size_t size) noexcept
+{
+    return reduce(mix_hash(hash + displacement * 0x9E3779B97F4A7C15ull), size);
+}
+
+bool perfect_hash::build(const key_map& keys)
+{
+    clear();
+
+    const std::size_t size = keys.size();
+    if (size == 0)
+    {
+        m_built = true;
+        return true;
+    }
+
+    const std::size_t bucket_count = (size + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+
+    std::vector<entry> items;
+    items.reserve(size);
+    for (const auto& key : keys)
+    {
+        items.push_back({ hash_key(key.first), key.first, key.second });
+    }
+
+    std::vector<std::vector<std::size_t>> buckets(bucket_count);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        buckets[reduce(items[i].hash << 32, bucket_count)].push_back(i);
+    }
+
+    // the largest buckets are the hardest to place,
+    // so they go first while most slots are free
+    std::vector<std::size_t> order(bucket_count);
+    for (std::size_t i = 0; i < bucket_count; ++i)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&buckets](std::size_t a, std::size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<bool> used(size, false);
+    std::vector<std::size_t> slots;
+
+    m_displacements.assign(bucket_count, 0);
+    m_entries.resize(size);
+
+    for (const std::size_t b : order)
+    {
+        const std::vector<std::size_t>& bucket = buckets[b];
+        if (bucket.empty())
+        {
+            break;
+        }
+
+        std::uint32_t displacement = 0;
+        for (; displacement < MAX_DISPLACEMENT; ++displacement)
+        {
+            slots.clear();
+            for (const std::size_t i : bucket)
+            {
+                const std::size_t s = slot(items[i].hash, displacement, size);
+                if (used[s] || (std::find(slots.begin(), slots.end(), s) != slots.end()))
+                {
+                    break;
+                }
+
+                slots.push_back(s);
+            }
+
+            if (slots.size() == bucket.size())
+            {
+                break;
+            }
+        }
+
+        // only happens for keys with equal 64 bit hashes
+        if (displacement == MAX_DISPLACEMENT)
+        {
+            clear();
+            return false;
+        }
+
+        m_displacements[b] = displacement;
+        for (std::size_t k = 0; k < bucket.size(); ++k)
+        {
+            used[slots[k]] = true;
+            m_entries[slots[k]] = items[bucket[k]];
+        }
+    }
+
+    m_built = true;
+    return true;
+}
+
+void perfect_hash::clear()
+{
+    m_entries.clear();
+    m_displacements.clear();
+    m_built = false;
+}
+
+bool perfect_hash::is_built() const noexcept
+{
+    return m_built;
+}
+
+std::size_t perfect_hash::size() const noexcept
+{
+    return m_entries.size();
+}
+
+std::size_t perfect_hash::find(std::string_view key) const noexcept
+{
+    return find(key, hash_key(key));
+}
+
+std::size_t perfect_hash::find(std::string_view key, std::uint64_t hash) const noexcept
+{
+    if (m_entries.empty())
+    {
+        return npos;
+    }
+
+    const std::uint32_t displacement = m_displacements[reduce(hash << 32, m_displacements.size())];
+    const entry& e = m_entries[slot(hash, displacement, m_entries.size())];
+
+    return ((e.hash == hash) && (e.key == key)) ? e.value : npos;
+}
+
+} // detail
+} // configparser
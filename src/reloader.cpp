@@ -0,0 +1,275 @@
+#include "reloader.h"
+#include <chrono> // milliseconds
+#include <filesystem> // path, last_write_time
+#include <system_error> // error_code
+
+#if defined(__linux__)
+#define CP_HAS_INOTIFY 1
+#include <cerrno> // errno
+#include <fcntl.h> // O_CLOEXEC
+#include <poll.h> // poll
+#include <sys/inotify.h> // inotify_init1, inotify_add_watch
+#include <unistd.h> // pipe2, read, write, close
+#endif
+
+namespace configparser
+{
+
+#ifndef CP_HAS_INOTIFY
+namespace
+{
+    // without inotify the file is checked this often
+    constexpr std::chrono::milliseconds POLL_INTERVAL{ 250 };
+} // anonymous
+#endif
+
+config_reloader::config_reloader(std::string path, const ConfigParser& settings)
+    : m_path(std::move(path))
+    , m_snapshot(std::make_shared<const ConfigParser>())
+{
+    m_settings.copy_settings(settings);
+    m_file_name = std::filesystem::path(m_path).filename().string();
+}
+
+config_reloader::~config_reloader()
+{
+    stop();
+}
+
+bool config_reloader::reload()
+{
+    std::lock_guard<std::mutex> lock(m_reload_mutex);
+
+    auto parser = std::make_shared<ConfigParser>();
+    parser->copy_settings(m_settings);
+
+    const bool ok = parser->parse_file(m_path.c_str());
+
+    m_error_code = parser->error_code();
+    m_error_line = parser->get_error_line();
+    m_error_column = parser->get_error_column();
+
+    if (ok)
+    {
+        // the snapshot is swapped before the generation changes,
+        // so a reader seeing the new generation finds it
+        std::atomic_store(&m_snapshot, config_snapshot(std::move(parser)));
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    return ok;
+}
+
+bool config_reloader::start()
+{
+    if (m_thread.joinable())
+    {
+        return true;
+    }
+
+#ifdef CP_HAS_INOTIFY
+    // the directory is watched, as editors often replace
+    // the file instead of writing into it
+    std::string directory = std::filesystem::path(m_path).parent_path().string();
+    if (directory.empty())
+    {
+        directory = ".";
+    }
+
+    m_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_watch_fd < 0)
+    {
+        return false;
+    }
+
+    if ((inotify_add_watch(m_watch_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) ||
+        (pipe2(m_stop_fds, O_CLOEXEC) < 0))
+    {
+        close(m_watch_fd);
+        m_watch_fd = -1;
+        return false;
+    }
+#endif
+
+    m_stopping = false;
+    reload();
+
+    m_thread = std::thread(&config_reloader::watch, this);
+    return true;
+}
+
+void config_reloader::stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_stop_mutex);
+        m_stopping = true;
+    }
+
+    m_stop_condition.notify_all();
+
+#ifdef CP_HAS_INOTIFY
+    const char wake = 0;
+    while ((write(m_stop_fds[1], &wake, 1) < 0) && (errno == EINTR))
+    {
+    }
+#endif
+
+    m_thread.join();
+
+#ifdef CP_HAS_INOTIFY
+    close(m_watch_fd);
+    close(m_stop_fds[0]);
+    close(m_stop_fds[1]);
+    m_watch_fd = -1;
+    m_stop_fds[0] = -1;
+    m_stop_fds[1] = -1;
+#endif
+}
+
+bool config_reloader::is_watching() const
+{
+    return m_thread.joinable();
+}
+
+void config_reloader::watch()
+{
+#ifdef CP_HAS_INOTIFY
+    pollfd fds[2] = {
+        { m_watch_fd, POLLIN, 0 },
+        { m_stop_fds[0], POLLIN, 0 }
+    };
+
+    while (!m_stopping)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        if (fds[1].revents != 0)
+        {
+            return;
+        }
+
+        // all queued events are taken at once, a file
+        // written in several steps is parsed once
+        bool changed = false;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t size;
+        while ((size = read(m_watch_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (const char* ptr = buffer; ptr < buffer + size; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                if (((event->mask & IN_Q_OVERFLOW) != 0) ||
+                    ((event->len != 0) && (m_file_name == event->name)))
+                {
+                    changed = true;
+                }
+
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (changed)
+        {
+            reload();
+        }
+    }
+#else
+    const auto last_write = [this]() {
+        std::error_code ec;
+        return std::filesystem::last_write_time(m_path, ec);
+    };
+
+    auto previous = last_write();
+    std::unique_lock<std::mutex> lock(m_stop_mutex);
+    while (!m_stop_condition.wait_for(lock, POLL_INTERVAL, [this]() { return m_stopping.load(); }))
+    {
+        const auto current = last_write();
+        if (current != previous)
+        {
+            previous = current;
+
+            lock.unlock();
+            reload();
+            lock.lock();
+        }
+    }
+#endif
+}
+
+config_snapshot config_reloader::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+std::uint64_t config_reloader::generation() const noexcept
+{
+    return m_generation.load(std::memory_order_acquire);
+}
+
+ErrorCode config_reloader::error_code() const
+{
+    std::lock_guard<std::mutex> lock(m_reload_mutex);
+    return m_error_code;
+}
+
+int config_reloader::get_error_line() const
+{
+    std::lock_guard<std::mutex> lock(m_reload_mutex);
+    return m_error_line;
+}
+
+int config_reloader::get_error_column() const
+{
+    std::lock_guard<std::mutex> lock(m_reload_mutex);
+    return m_error_column;
+}
+
+const std::string& config_reloader::path() const noexcept
+{
+    return m_path;
+}
+
+snapshot_reader::snapshot_reader(const config_reloader& reloader)
+    : m_reloader(reloader)
+{
+    refresh(reloader.generation());
+}
+
+const ConfigParser& snapshot_reader::current()
+{
+    return *snapshot();
+}
+
+const config_snapshot& snapshot_reader::snapshot()
+{
+    const std::uint64_t generation = m_reloader.generation();
+    if (generation != m_generation)
+    {
+        refresh(generation);
+    }
+
+    return m_snapshot;
+}
+
+void snapshot_reader::refresh(std::uint64_t generation)
+{
+    // a newer snapshot may already be in place, it is
+    // then simply taken once more by the next call
+    m_snapshot = m_reloader.snapshot();
+    m_generation = generation;
+}
+
+} // configparser
@@ -0,0 +1,414 @@
+#include "scan.h"
+#include "char_class.h"
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CP_HAS_X86_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h> // __cpuid, _BitScanForward
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CP_TARGET_AVX2 __attribute__((target("avx2")))
+#define CP_NO_SANITIZE __attribute__((no_sanitize_address, no_sanitize_thread))
+#define CP_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define CP_TARGET_AVX2
+#define CP_NO_SANITIZE
+#define CP_FORCE_INLINE __forceinline
+#endif
+
+namespace configparser
+{
+namespace detail
+{
+
+namespace
+{
+    bool is_identifier_char(char c)
+    {
+        return is_identifier_class(char_class(c));
+    }
+
+    const char* scalar_line_end(const char* text)
+    {
+        while ((*text != '\n') && (*text != 0))
+        {
+            ++text;
+        }
+
+        return text;
+    }
+
+    const char* scalar_value_end(const char* text, bool& has_comma, bool& has_colon)
+    {
+        while ((*text != '\n') && (*text != ';') && (*text != 0))
+        {
+            has_comma |= (*text == ',');
+            has_colon |= (*text == ':');
+            ++text;
+        }
+
+        return text;
+    }
+
+    const char* scalar_identifier_end(const char* text)
+    {
+        while (is_identifier_char(*text))
+        {
+            ++text;
+        }
+
+        return text;
+    }
+
+#ifdef CP_HAS_X86_SIMD
+    unsigned first_bit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return (unsigned)idx;
+#else
+        return (unsigned)__builtin_ctz(mask);
+#endif
+    }
+
+    // the block containing the first character is read from its
+    // aligned start, the bits of the characters before are dropped;
+    // aligned loads never cross into the next (possibly unmapped) page
+
+    CP_NO_SANITIZE
+    const char* sse2_line_end(const char* text)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i zero = _mm_setzero_si128();
+
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 15);
+        const char* block = text - offset;
+
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, zero)));
+        mask &= ~0u << offset;
+
+        while (mask == 0)
+        {
+            block += 16;
+            v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+            mask = (unsigned)_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, zero)));
+        }
+
+        return block + first_bit(mask);
+    }
+
+    CP_NO_SANITIZE
+    const char* sse2_value_end(const char* text, bool& has_comma, bool& has_colon)
+    {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i semicolon = _mm_set1_epi8(';');
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i colon = _mm_set1_epi8(':');
+
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 15);
+        const char* block = text - offset;
+        unsigned valid = 0xFFFFu << offset;
+
+        unsigned comma_mask = 0;
+        unsigned colon_mask = 0;
+        for (;;)
+        {
+            const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+            unsigned stop = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, semicolon)),
+                _mm_cmpeq_epi8(v, zero)));
+            stop &= valid;
+
+            // only separators before the end of the value count
+            if (stop != 0)
+            {
+                valid &= (stop & (0u - stop)) - 1;
+            }
+
+            comma_mask |= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)) & valid;
+            colon_mask |= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, colon)) & valid;
+
+            if (stop != 0)
+            {
+                has_comma |= (comma_mask != 0);
+                has_colon |= (colon_mask != 0);
+                return block + first_bit(stop);
+            }
+
+            block += 16;
+            valid = 0xFFFFu;
+        }
+    }
+
+    // inlined, so that the callers leave the
+    // vector registers clean (vzeroupper) on return
+    CP_FORCE_INLINE CP_NO_SANITIZE
+    unsigned sse2_identifier_mask(__m128i v)
+    {
+        // letters are checked case-insensitively, ranges are
+        // checked with unsigned min/max as SSE2 has no unsigned compare
+        const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        const __m128i letters = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_max_epu8(lower, _mm_set1_epi8('a')), lower),
+            _mm_cmpeq_epi8(_mm_min_epu8(lower, _mm_set1_epi8('z')), lower));
+        const __m128i digits = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8('0')), v),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8('9')), v));
+
+        __m128i specials = _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('.')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('$')));
+        specials = _mm_or_si128(specials, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+        specials = _mm_or_si128(specials, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        specials = _mm_or_si128(specials, _mm_cmpeq_epi8(v, _mm_set1_epi8('~')));
+        specials = _mm_or_si128(specials, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+        specials = _mm_or_si128(specials, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+
+        return (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_or_si128(letters, digits), specials));
+    }
+
+    CP_NO_SANITIZE
+    const char* sse2_identifier_end(const char* text)
+    {
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 15);
+        const char* block = text - offset;
+
+        unsigned mask = ~sse2_identifier_mask(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+        mask &= (0xFFFFu << offset) & 0xFFFFu;
+
+        while (mask == 0)
+        {
+            block += 16;
+            mask = ~sse2_identifier_mask(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(block))) & 0xFFFFu;
+        }
+
+        return block + first_bit(mask);
+    }
+
+    CP_TARGET_AVX2 CP_NO_SANITIZE
+    const char* avx2_line_end(const char* text)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i zero = _mm256_setzero_si256();
+
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 31);
+        const char* block = text - offset;
+
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, zero)));
+        mask &= ~0u << offset;
+
+        while (mask == 0)
+        {
+            block += 32;
+            v = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+            mask = (unsigned)_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, zero)));
+        }
+
+        return block + first_bit(mask);
+    }
+
+    CP_TARGET_AVX2 CP_NO_SANITIZE
+    const char* avx2_value_end(const char* text, bool& has_comma, bool& has_colon)
+    {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i semicolon = _mm256_set1_epi8(';');
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i comma = _mm256_set1_epi8(',');
+        const __m256i colon = _mm256_set1_epi8(':');
+
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 31);
+        const char* block = text - offset;
+        unsigned valid = ~0u << offset;
+
+        unsigned comma_mask = 0;
+        unsigned colon_mask = 0;
+        for (;;)
+        {
+            const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+            unsigned stop = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, newline), _mm256_cmpeq_epi8(v, semicolon)),
+                _mm256_cmpeq_epi8(v, zero)));
+            stop &= valid;
+
+            if (stop != 0)
+            {
+                valid &= (stop & (0u - stop)) - 1;
+            }
+
+            comma_mask |= (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, comma)) & valid;
+            colon_mask |= (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, colon)) & valid;
+
+            if (stop != 0)
+            {
+                has_comma |= (comma_mask != 0);
+                has_colon |= (colon_mask != 0);
+                return block + first_bit(stop);
+            }
+
+            block += 32;
+            valid = ~0u;
+        }
+    }
+
+    CP_FORCE_INLINE CP_TARGET_AVX2 CP_NO_SANITIZE
+    unsigned avx2_identifier_mask(__m256i v)
+    {
+        const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const __m256i letters = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_max_epu8(lower, _mm256_set1_epi8('a')), lower),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(lower, _mm256_set1_epi8('z')), lower));
+        const __m256i digits = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8('0')), v),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8('9')), v));
+
+        __m256i specials = _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')));
+        specials = _mm256_or_si256(specials, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')));
+        specials = _mm256_or_si256(specials, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        specials = _mm256_or_si256(specials, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('~')));
+        specials = _mm256_or_si256(specials, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+        specials = _mm256_or_si256(specials, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+
+        return (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_or_si256(letters, digits), specials));
+    }
+
+    CP_TARGET_AVX2 CP_NO_SANITIZE
+    const char* avx2_identifier_end(const char* text)
+    {
+        const unsigned offset = (unsigned)((std::uintptr_t)text & 31);
+        const char* block = text - offset;
+
+        unsigned mask = ~avx2_identifier_mask(
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+        mask &= ~0u << offset;
+
+        while (mask == 0)
+        {
+            block += 32;
+            mask = ~avx2_identifier_mask(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+        }
+
+        return block + first_bit(mask);
+    }
+
+    bool cpu_has_avx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // the os has to save the ymm registers too
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || ((_xgetbv(0) & 6) != 6))
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // CP_HAS_X86_SIMD
+
+    ScanLevel supported_scan_level()
+    {
+#ifdef CP_HAS_X86_SIMD
+        return cpu_has_avx2() ? ScanLevel::SCAN_AVX2 : ScanLevel::SCAN_SSE2;
+#else
+        return ScanLevel::SCAN_SCALAR;
+#endif
+    }
+
+    std::atomic<ScanLevel>& current_scan_level()
+    {
+        static std::atomic<ScanLevel> level{ supported_scan_level() };
+        return level;
+    }
+} // anonymous
+
+ScanLevel scan_level()
+{
+    return current_scan_level().load(std::memory_order_relaxed);
+}
+
+void set_scan_level(ScanLevel level)
+{
+    const ScanLevel supported = supported_scan_level();
+    current_scan_level().store((level < supported) ? level : supported,
+        std::memory_order_relaxed);
+}
+
+const char* scan_line_end(const char* text)
+{
+    switch (scan_level())
+    {
+#ifdef CP_HAS_X86_SIMD
+        case ScanLevel::SCAN_AVX2:
+            return avx2_line_end(text);
+        case ScanLevel::SCAN_SSE2:
+            return sse2_line_end(text);
+#endif
+        default:
+            return scalar_line_end(text);
+    }
+}
+
+const char* scan_value_end(const char* text, bool& has_comma, bool& has_colon)
+{
+    switch (scan_level())
+    {
+#ifdef CP_HAS_X86_SIMD
+        case ScanLevel::SCAN_AVX2:
+            return avx2_value_end(text, has_comma, has_colon);
+        case ScanLevel::SCAN_SSE2:
+            return sse2_value_end(text, has_comma, has_colon);
+#endif
+        default:
+            return scalar_value_end(text, has_comma, has_colon);
+    }
+}
+
+const char* scan_identifier_end(const char* text)
+{
+    switch (scan_level())
+    {
+#ifdef CP_HAS_X86_SIMD
+        case ScanLevel::SCAN_AVX2:
+            return avx2_identifier_end(text);
+        case ScanLevel::SCAN_SSE2:
+            return sse2_identifier_end(text);
+#endif
+        default:
+            return scalar_identifier_end(text);
+    }
+}
+
+} // detail
+} // configparser
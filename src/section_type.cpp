@@ -1,4 +1,5 @@
 #include "section_type.h"
+#include <stdexcept> // out_of_range
 
 namespace configparser
 {
@@ -8,22 +9,84 @@ const option_vector& section_type::options() const
     return m_options;
 }
 
-const option_type& section_type::option(const std::string& option_name) const
+const option_type& section_type::option(std::string_view option_name) const
+{
+    const option_type* opt = find_option(option_name);
+    if (opt == nullptr)
+    {
+        throw std::out_of_range("configparser: no such option");
+    }
+
+    return *opt;
+}
+
+const option_type* section_type::find_option(std::string_view option_name) const noexcept
+{
+    const size_t idx = find_index(option_name);
+    return (idx != detail::perfect_hash::npos) ? &m_options[idx] : nullptr;
+}
+
+size_t section_type::find_index(std::string_view option_name) const noexcept
+{
+    if (m_options_index.is_built())
+    {
+        return m_options_index.find(option_name);
+    }
+
+    const auto it = m_options_map.find(option_name);
+    return (it != m_options_map.end()) ? it->second : detail::perfect_hash::npos;
+}
+
+size_t section_type::find_index(std::string_view option_name, std::uint64_t hash) const noexcept
+{
+    if (m_options_index.is_built())
+    {
+        return m_options_index.find(option_name, hash);
+    }
+
+    return find_index(option_name);
+}
+
+void section_type::freeze()
+{
+    m_options_index.build(m_options_map);
+}
+
+section_type::section_type(std::string_view name) noexcept
+    : m_name(name)
+{
+}
+
+section_type::section_type(std::string_view name, const allocator_type& alloc) noexcept
+    : m_name(name)
+    , m_options(alloc)
+    , m_options_map(alloc)
+    , m_options_index(alloc)
+{
+}
+
+section_type::section_type(const section_type& other, const allocator_type& alloc)
+    : m_name(other.m_name)
+    , m_options(other.m_options, alloc)
+    , m_options_map(other.m_options_map, alloc)
+    , m_options_index(other.m_options_index, alloc)
 {
-    return m_options[m_options_map.at(option_name)];
 }
 
-section_type::section_type(std::string&& name) noexcept
-    : m_name(std::move(name))
+section_type::section_type(section_type&& other, const allocator_type& alloc)
+    : m_name(other.m_name)
+    , m_options(std::move(other.m_options), alloc)
+    , m_options_map(std::move(other.m_options_map), alloc)
+    , m_options_index(std::move(other.m_options_index), alloc)
 {
 }
 
-bool section_type::has_option(const std::string& option_name) const
+bool section_type::has_option(std::string_view option_name) const noexcept
 {
-    return m_options_map.find(option_name) != m_options_map.end();
+    return find_index(option_name) != detail::perfect_hash::npos;
 }
 
-const std::string& section_type::name() const
+std::string_view section_type::name() const
 {
     return m_name;
 }
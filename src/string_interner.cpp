@@ -0,0 +1,101 @@
+#include "string_interner.h"
+#include "perfect_hash.h"
+
+namespace configparser
+{
+
+string_interner::~string_interner()
+{
+    // values still holding a string keep it alive
+    for (shard& s : m_shards)
+    {
+        for (const slot& sl : s.slots)
+        {
+            if ((sl.str != nullptr) && (sl.str->refs.fetch_sub(1, std::memory_order_acq_rel) == 1))
+            {
+                delete sl.str;
+            }
+        }
+    }
+}
+
+void string_interner::grow(shard& s)
+{
+    std::vector<slot> slots(s.slots.empty() ? 64 : s.slots.size() * 2, slot{ 0, nullptr });
+    const std::size_t mask = slots.size() - 1;
+
+    for (const slot& sl : s.slots)
+    {
+        if (sl.str != nullptr)
+        {
+            std::size_t idx = sl.hash & mask;
+            while (slots[idx].str != nullptr)
+            {
+                idx = (idx + 1) & mask;
+            }
+
+            slots[idx] = sl;
+        }
+    }
+
+    s.slots.swap(slots);
+}
+
+detail::shared_string* string_interner::find_or_add(std::string_view str)
+{
+    // the top bits pick the shard, the low bits the slot
+    const std::uint64_t hash = detail::hash_key(str);
+    shard& s = m_shards[hash >> 60];
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    // kept at most half full
+    if (2 * (s.count + 1) > s.slots.size())
+    {
+        grow(s);
+    }
+
+    const std::size_t mask = s.slots.size() - 1;
+    std::size_t idx = hash & mask;
+    while (s.slots[idx].str != nullptr)
+    {
+        const slot& sl = s.slots[idx];
+        if ((sl.hash == hash) && (sl.str->str == str))
+        {
+            return sl.str;
+        }
+
+        idx = (idx + 1) & mask;
+    }
+
+    // the interner holds one reference
+    detail::shared_string* stored = new detail::shared_string(std::string{ str });
+    s.slots[idx] = { hash, stored };
+    ++s.count;
+
+    return stored;
+}
+
+std::string_view string_interner::intern(std::string_view str)
+{
+    return find_or_add(str)->str;
+}
+
+value_type string_interner::intern_value(std::string_view str)
+{
+    return value_type::from_shared(find_or_add(str));
+}
+
+std::size_t string_interner::size() const
+{
+    std::size_t size = 0;
+    for (const shard& s : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        size += s.count;
+    }
+
+    return size;
+}
+
+} // configparser
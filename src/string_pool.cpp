@@ -0,0 +1,91 @@
+#include "string_pool.h"
+#include <cassert> // assert
+#include <cstring> // memcpy
+
+namespace configparser
+{
+namespace detail
+{
+
+string_pool::string_pool(std::pmr::memory_resource* resource,
+    std::shared_ptr<std::pmr::memory_resource> owner)
+    : m_owner(std::move(owner))
+    , m_resource(resource)
+{
+}
+
+string_pool::~string_pool()
+{
+    clear();
+}
+
+char* string_pool::allocate(std::size_t size)
+{
+    char* ptr = static_cast<char*>(m_resource->allocate(size, 1));
+    m_blocks.push_back({ ptr, size });
+
+    return ptr;
+}
+
+std::string_view string_pool::store(std::string_view str)
+{
+    if (str.empty())
+    {
+        return { "", 0 };
+    }
+
+    // stored strings are NUL terminated, so they can be
+    // handed to the value parsers like the parsed text
+    const std::size_t size = str.size() + 1;
+
+    // strings larger than a block get a block of their own,
+    // so the current block can still be filled afterwards
+    if (size > BLOCK_SIZE / 4)
+    {
+        char* ptr = allocate(size);
+        memcpy(ptr, str.data(), str.size());
+        ptr[str.size()] = 0;
+        return { ptr, str.size() };
+    }
+
+    if (size > m_block_left)
+    {
+        m_block_ptr = allocate(BLOCK_SIZE);
+        m_block_left = BLOCK_SIZE;
+    }
+
+    char* ptr = m_block_ptr;
+    memcpy(ptr, str.data(), str.size());
+    ptr[str.size()] = 0;
+
+    m_block_ptr += size;
+    m_block_left -= size;
+
+    return { ptr, str.size() };
+}
+
+void string_pool::clear()
+{
+    for (const block& b : m_blocks)
+    {
+        m_resource->deallocate(b.ptr, b.size, 1);
+    }
+
+    m_blocks.clear();
+    m_block_ptr = nullptr;
+    m_block_left = 0;
+}
+
+void string_pool::adopt(string_pool& other)
+{
+    assert(other.m_resource == m_resource);
+
+    m_blocks.insert(m_blocks.end(), other.m_blocks.begin(), other.m_blocks.end());
+
+    other.m_blocks.clear();
+    other.m_block_ptr = nullptr;
+    other.m_block_left = 0;
+}
+
+} // detail
+} // configparser
@@ -1,11 +1,71 @@
 #include "tokenizer.h"
-#include <cctype> // isalpha, isdigit
+#include "scan.h"
+#include "char_class.h"
+#include <cstring> // memchr
 
 namespace configparser
 {
 namespace detail
 {
 
+namespace
+{
+    enum class LexState
+    {
+        LEX_LINE, // between tokens
+        LEX_IDENTIFIER, // right after an identifier
+
+        LEX_NUM
+    }; // LexState
+
+    enum class LexAction : unsigned char
+    {
+        ACTION_SKIP,
+        ACTION_NEWLINE,
+        ACTION_COMMENT,
+        ACTION_SECTION,
+        ACTION_VALUE,
+        ACTION_IDENTIFIER,
+        ACTION_ESCAPE, // identifier, if a space is escaped
+        ACTION_END,
+        ACTION_ERROR,
+
+        ACTION_NUM
+    }; // LexAction
+
+    using lex_row = LexAction[(size_t)CharClass::CHAR_NUM];
+
+    // indexed by [LexState][CharClass]
+    constexpr lex_row lex_actions[(size_t)LexState::LEX_NUM] = {
+        { // LEX_LINE
+            LexAction::ACTION_ERROR, // CHAR_OTHER
+            LexAction::ACTION_IDENTIFIER, // CHAR_IDENTIFIER_START
+            LexAction::ACTION_ERROR, // CHAR_IDENTIFIER
+            LexAction::ACTION_SKIP, // CHAR_SPACE
+            LexAction::ACTION_SKIP, // CHAR_BLANK
+            LexAction::ACTION_NEWLINE, // CHAR_NEWLINE
+            LexAction::ACTION_COMMENT, // CHAR_COMMENT
+            LexAction::ACTION_SECTION, // CHAR_SECTION
+            LexAction::ACTION_VALUE, // CHAR_VALUE
+            LexAction::ACTION_ESCAPE, // CHAR_ESCAPE
+            LexAction::ACTION_END, // CHAR_END
+        },
+        { // LEX_IDENTIFIER
+            LexAction::ACTION_ERROR, // CHAR_OTHER
+            LexAction::ACTION_ERROR, // CHAR_IDENTIFIER_START
+            LexAction::ACTION_ERROR, // CHAR_IDENTIFIER
+            LexAction::ACTION_SKIP, // CHAR_SPACE
+            LexAction::ACTION_SKIP, // CHAR_BLANK
+            LexAction::ACTION_NEWLINE, // CHAR_NEWLINE
+            LexAction::ACTION_COMMENT, // CHAR_COMMENT
+            LexAction::ACTION_SECTION, // CHAR_SECTION
+            LexAction::ACTION_VALUE, // CHAR_VALUE
+            LexAction::ACTION_ERROR, // CHAR_ESCAPE
+            LexAction::ACTION_ERROR, // CHAR_END, a key without a value
+        },
+    };
+} // anonymous
+
 char tokenizer::peek() const
 {
     return *m_text_ptr;
@@ -27,6 +87,14 @@ void tokenizer::consume()
     ++m_column;
 }
 
+void tokenizer::advance(const char* ptr)
+{
+    // only used within a line, so the column moves by the
+    // number of skipped characters
+    m_column += (int)(ptr - m_text_ptr);
+    m_text_ptr = ptr;
+}
+
 bool tokenizer::eof() const
 {
     return peek() == 0;
@@ -45,55 +113,37 @@ bool tokenizer::empty() const
 
 void tokenizer::comment()
 {
-    while (peek() != '\n')
-    {
-        consume();
-    }
+    advance(scan_line_end(m_text_ptr));
 }
 
-bool tokenizer::is_identifier_start()
+bool tokenizer::is_escaped_space() const
 {
-    const bool escaped_start =
-        (peek() == '\\') &&
+    return (peek() == '\\') &&
         (peekNext() == ' ');
-
-    return escaped_start ||
-        isalpha(peek()) ||
-        (peek() == '.') ||
-        (peek() == '$') ||
-        (peek() == ':');
 }
 
-bool tokenizer::is_identifier_char()
+bool tokenizer::is_identifier_char() const
 {
-    return is_identifier_start() ||
-        isdigit(peek()) ||
-        (peek() == '_') ||
-        (peek() == '~') ||
-        (peek() == '-') ||
-        (peek() == '.') ||
-        (peek() == ':') ||
-        (peek() == ' ');
+    return is_identifier_class(char_class(peek())) ||
+        is_escaped_space();
 }
 
-bool tokenizer::priority_value_separator(char val)
+void tokenizer::identifier_chars()
 {
-    return val == ',';
-}
-
-bool tokenizer::value_separator(char val)
-{
-    return (val == ':') ||
-        (val == ',');
+    // the scanner stops at every '\\', which is only part
+    // of an identifier when it escapes a space
+    advance(scan_identifier_end(m_text_ptr));
+    while (is_identifier_char())
+    {
+        consume();
+        advance(scan_identifier_end(m_text_ptr));
+    }
 }
 
 void tokenizer::identifier()
 {
     const char* begin_ptr = m_text_ptr;
-    while (is_identifier_char())
-    {
-        consume();
-    }
+    identifier_chars();
 
     const char* end_ptr = m_text_ptr - 1;
 
@@ -103,12 +153,7 @@ void tokenizer::identifier()
         --end_ptr;
     }
 
-    m_tokens.emplace_back();
-    m_tokens.back().type = TokenType::TOKEN_IDENTIFIER;
-    m_tokens.back().begin_ptr = begin_ptr;
-    m_tokens.back().length = end_ptr - begin_ptr + 1;
-    m_tokens.back().line = m_line;
-    m_tokens.back().column = m_column - 1;
+    emit(TokenType::TOKEN_IDENTIFIER, begin_ptr, end_ptr - begin_ptr + 1, m_column - 1);
 }
 
 void tokenizer::section()
@@ -116,10 +161,7 @@ void tokenizer::section()
     consume(); // '['
 
     const char* begin_ptr = m_text_ptr;
-    while (is_identifier_char())
-    {
-        consume();
-    }
+    identifier_chars();
 
     // check for bracket at the end of
     // section define
@@ -130,12 +172,8 @@ void tokenizer::section()
     }
     else
     {
-        m_tokens.emplace_back();
-        m_tokens.back().type = TokenType::TOKEN_SECTION;
-        m_tokens.back().begin_ptr = begin_ptr;
-        m_tokens.back().length = m_text_ptr - begin_ptr;
-        m_tokens.back().line = m_line;
-        m_tokens.back().column = m_column - (int)m_tokens.back().length;
+        const std::ptrdiff_t length = m_text_ptr - begin_ptr;
+        emit(TokenType::TOKEN_SECTION, begin_ptr, length, m_column - (int)length);
         consume(); // ']'
     }
 }
@@ -152,19 +190,14 @@ void tokenizer::value()
     }
 
     const char* begin_ptr = m_text_ptr;
-    char sep = 0; // save items separator, if exists
-    while (!eof() && !eol() && (peek() != ';'))
-    {
-        // save the items separator, with higher priority
-        // to one of them
-        if (!priority_value_separator(sep) &&
-            value_separator(peek()))
-        {
-            sep = peek();
-        }
 
-        consume();
-    }
+    // save the items separator, if exists, with
+    // higher priority to one of them
+    bool has_comma = false;
+    bool has_colon = false;
+    advance(scan_value_end(m_text_ptr, has_comma, has_colon));
+
+    const char sep = has_comma ? ',' : (has_colon ? ':' : 0);
 
     const TokenType token_type = (sep == 0) ?
         TokenType::TOKEN_VALUE :
@@ -174,10 +207,8 @@ void tokenizer::value()
     while (current_ptr < m_text_ptr)
     {
         // consume everything until items separator
-        while ((current_ptr < m_text_ptr) && (*current_ptr != sep))
-        {
-            ++current_ptr;
-        }
+        const void* sep_ptr = memchr(current_ptr, sep, m_text_ptr - current_ptr);
+        current_ptr = (sep_ptr != nullptr) ? static_cast<const char*>(sep_ptr) : m_text_ptr;
 
         const char* end_ptr = current_ptr - 1;
 
@@ -196,12 +227,8 @@ void tokenizer::value()
             }
         }
 
-        m_tokens.emplace_back();
-        m_tokens.back().type = token_type;
-        m_tokens.back().begin_ptr = begin_ptr;
-        m_tokens.back().length = end_ptr - begin_ptr + 1;
-        m_tokens.back().line = m_line;
-        m_tokens.back().column = m_column - (int)(m_text_ptr - begin_ptr);
+        emit(token_type, begin_ptr, end_ptr - begin_ptr + 1,
+            m_column - (int)(m_text_ptr - begin_ptr));
 
         // if a comment follows the value, then
         // no more parsing is needed
@@ -226,43 +253,103 @@ void tokenizer::value()
     }
 }
 
-ErrorCode tokenizer::parse(const char* text)
+void tokenizer::emit(TokenType type, const char* begin_ptr, std::ptrdiff_t length, int column)
 {
+    const token t{ type, begin_ptr, length, m_line, column };
+    if (m_sink != nullptr)
+    {
+        m_sink->on_token(t);
+    }
+    else
+    {
+        m_tokens.push_back(t);
+    }
+}
+
+ErrorCode tokenizer::parse(const char* text, int line, int column)
+{
+    m_tokens.clear();
+    m_sink = nullptr;
+
+    return run(text, line, column);
+}
+
+ErrorCode tokenizer::parse(const char* text, token_sink& sink, int line, int column)
+{
+    // tokens are handed over as they are found,
+    // so the tokens vector stays empty
     m_tokens.clear();
+    m_sink = &sink;
+
+    const ErrorCode error_code = run(text, line, column);
+    m_sink = nullptr;
+
+    return error_code;
+}
+
+ErrorCode tokenizer::parse(const char* text, const char* end, token_sink& sink, int line, int column)
+{
+    m_end_ptr = end;
+    const ErrorCode error_code = parse(text, sink, line, column);
+    m_end_ptr = nullptr;
+
+    return error_code;
+}
+
+ErrorCode tokenizer::run(const char* text, int line, int column)
+{
     m_text_ptr = text;
     m_error_code = ErrorCode::NO_ERROR;
 
-    m_line = 1;
-    m_column = 1;
+    m_line = line;
+    m_column = column;
 
-    while (!eof() && (m_error_code == ErrorCode::NO_ERROR))
+    LexState state = LexState::LEX_LINE;
+    while (m_error_code == ErrorCode::NO_ERROR)
     {
-        if (is_identifier_start())
-        {
-            identifier();
-        }
+        const CharClass char_cls = char_class(peek());
+        const LexAction action = lex_actions[(size_t)state][(size_t)char_cls];
 
-        switch (peek())
+        state = LexState::LEX_LINE;
+        switch (action)
         {
-            case ' ':
-            case '\t':
-            case '\r':
+            case LexAction::ACTION_SKIP:
                 consume();
                 break;
-            case '\n':
+            case LexAction::ACTION_NEWLINE:
                 ++m_line;
                 m_column = 1;
                 consume();
+                // a range always ends at the start of a line
+                if (m_text_ptr == m_end_ptr)
+                {
+                    return m_error_code;
+                }
                 break;
-            case ';':
+            case LexAction::ACTION_COMMENT:
                 comment();
                 break;
-            case '[':
+            case LexAction::ACTION_SECTION:
                 section();
                 break;
-            case '=':
+            case LexAction::ACTION_VALUE:
                 value();
                 break;
+            case LexAction::ACTION_ESCAPE:
+                if (!is_escaped_space())
+                {
+                    m_error_code = ErrorCode::UNEXPECTED_CHARACTER;
+                    break;
+                }
+                identifier();
+                state = LexState::LEX_IDENTIFIER;
+                break;
+            case LexAction::ACTION_IDENTIFIER:
+                identifier();
+                state = LexState::LEX_IDENTIFIER;
+                break;
+            case LexAction::ACTION_END:
+                return m_error_code;
             default: // error
                 m_error_code = ErrorCode::UNEXPECTED_CHARACTER;
                 break;
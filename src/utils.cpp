@@ -1,20 +1,11 @@
 #include "utils.h"
-#include <cstdlib>
+#include <algorithm> // find
 
 namespace configparser
 {
 namespace detail
 {
 
-bool parse_integer_base(number& num, const char* text, std::ptrdiff_t length, int base)
-{
-    char* end_ptr = nullptr;
-    num.nb.l = std::strtol(text, &end_ptr, base);
-    num.type = NumberType::NUMBER_LONG;
-
-    return end_ptr == (text + length);
-}
-
 std::string remove_escapes(std::string&& str)
 {
     const bool has_escapes = std::find(str.begin(), str.end(), '\\') != str.end();
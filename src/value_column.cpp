@@ -0,0 +1,177 @@
+#include "value_column.h"
+
+namespace configparser
+{
+namespace detail
+{
+
+value_column::value_column(ValueType type, std::size_t size, std::pmr::memory_resource* resource)
+    : m_type(type)
+    , m_size(size)
+    , m_longs(resource)
+    , m_doubles(resource)
+    , m_bits(resource)
+{
+    switch (type)
+    {
+        case ValueType::VALUE_LONG:
+            m_longs.resize(size);
+            break;
+        case ValueType::VALUE_DOUBLE:
+            m_doubles.resize(size);
+            break;
+        case ValueType::VALUE_BOOLEAN:
+            m_bits.resize((size + 63) / 64);
+            break;
+        default:
+            break;
+    }
+}
+
+value_column::~value_column()
+{
+    values_vector* values = m_values.load(std::memory_order_acquire);
+    if (values != nullptr)
+    {
+        std::pmr::polymorphic_allocator<values_vector> alloc(std::pmr::new_delete_resource());
+        alloc.destroy(values);
+        alloc.deallocate(values, 1);
+    }
+}
+
+std::shared_ptr<value_column> value_column::build(const values_vector& values,
+    std::pmr::memory_resource* resource)
+{
+    // pending lazy values are not typed for the column
+    if (values.empty() || !values.front().is_resolved())
+    {
+        return nullptr;
+    }
+
+    const ValueType type = values.front().type();
+    if (type == ValueType::VALUE_STRING)
+    {
+        return nullptr;
+    }
+
+    for (const value_type& val : values)
+    {
+        if (!val.is_resolved() || (val.type() != type))
+        {
+            return nullptr;
+        }
+    }
+
+    const std::pmr::polymorphic_allocator<value_column> alloc(resource);
+    std::shared_ptr<value_column> column = std::allocate_shared<value_column>(alloc, type, values.size(), resource);
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        switch (type)
+        {
+            case ValueType::VALUE_LONG:
+                column->m_longs[i] = values[i].to_long();
+                break;
+            case ValueType::VALUE_DOUBLE:
+                column->m_doubles[i] = values[i].to_double();
+                break;
+            case ValueType::VALUE_BOOLEAN:
+                column->m_bits[i / 64] |= (std::uint64_t)values[i].to_bool() << (i % 64);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return column;
+}
+
+std::shared_ptr<value_column> value_column::copy(std::pmr::memory_resource* resource) const
+{
+    const std::pmr::polymorphic_allocator<value_column> alloc(resource);
+    std::shared_ptr<value_column> column = std::allocate_shared<value_column>(alloc, m_type, 0, resource);
+
+    column->m_size = m_size;
+    column->m_longs.assign(m_longs.begin(), m_longs.end());
+    column->m_doubles.assign(m_doubles.begin(), m_doubles.end());
+    column->m_bits.assign(m_bits.begin(), m_bits.end());
+
+    return column;
+}
+
+ValueType value_column::type() const noexcept
+{
+    return m_type;
+}
+
+std::size_t value_column::size() const noexcept
+{
+    return m_size;
+}
+
+span<const long> value_column::longs() const noexcept
+{
+    return { m_longs.data(), m_longs.size() };
+}
+
+span<const double> value_column::doubles() const noexcept
+{
+    return { m_doubles.data(), m_doubles.size() };
+}
+
+span<const std::uint64_t> value_column::bits() const noexcept
+{
+    return { m_bits.data(), m_bits.size() };
+}
+
+bool value_column::bit(std::size_t idx) const noexcept
+{
+    return ((m_bits[idx / 64] >> (idx % 64)) & 1) != 0;
+}
+
+const values_vector& value_column::values() const
+{
+    values_vector* values = m_values.load(std::memory_order_acquire);
+    if (values != nullptr)
+    {
+        return *values;
+    }
+
+    // readers racing here each build the values, the first
+    // one published is kept; they come from the heap, as
+    // the resource of the document may not be thread safe
+    std::pmr::polymorphic_allocator<values_vector> alloc(std::pmr::new_delete_resource());
+    values_vector* built = alloc.allocate(1);
+    alloc.construct(built);
+    built->reserve(m_size);
+
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        switch (m_type)
+        {
+            case ValueType::VALUE_LONG:
+                built->emplace_back(m_longs[i]);
+                break;
+            case ValueType::VALUE_DOUBLE:
+                built->emplace_back(m_doubles[i]);
+                break;
+            case ValueType::VALUE_BOOLEAN:
+                built->emplace_back(bit(i));
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!m_values.compare_exchange_strong(values, built, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        alloc.destroy(built);
+        alloc.deallocate(built, 1);
+        return *values;
+    }
+
+    return *built;
+}
+
+} // detail
+} // configparser
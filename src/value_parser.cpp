@@ -1,5 +1,19 @@
 #include "value_parser.h"
-#include <memory>
+#include <cfloat> // FLT_EVAL_METHOD
+#include <charconv> // from_chars
+#include <cstdint>
+#include <cstring> // memcpy
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h> // _BitScanForward64
+#endif
+
+// digits are converted 8 at a time within a 64 bit word,
+// which assumes the first character in the lowest byte
+#if defined(_WIN32) || (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define CP_HAS_SWAR_DIGITS 1
+#endif
 
 namespace configparser
 {
@@ -66,217 +80,371 @@ const std::string& link_parser::option() const
     return m_option;
 }
 
-bool number_parser::is_hexadecimal(const char* text, std::ptrdiff_t length)
+namespace
 {
-    // e.g.: 0xA1B2C3
-    return (length > 2) && // '0x'
-        (*text == '0') &&
-        (*(text + 1) == 'x');
-}
+    bool is_digit(char c)
+    {
+        return (c >= '0') && (c <= '9');
+    }
 
-bool number_parser::is_decimal(const char* text, std::ptrdiff_t length)
-{
-    // any type of number
-    return isdigit(*text) ||
-        (*text == '+') ||
-        (*text == '-');
-}
+    bool is_digit_or_hex(char c)
+    {
+        return is_digit(c) ||
+            ((c >= 'a') && (c <= 'f')) ||
+            ((c >= 'A') && (c <= 'F'));
+    }
 
-bool number_parser::is_octal(const char* text, std::ptrdiff_t length)
-{
-    // e.g.: 01337
-    return (length > 1) && // '0'
-        (*text == '0');
-}
+#ifdef CP_HAS_SWAR_DIGITS
+    constexpr std::uint64_t SWAR_ONES = 0x0101010101010101ull;
+    constexpr std::uint64_t SWAR_HIGH = 0x8080808080808080ull;
+    constexpr std::uint64_t SWAR_ZEROS = 0x3030303030303030ull; // '0'
+
+    // integers up to this many digits always fit a long (which
+    // may have 32 bits) and are converted here, longer ones (or
+    // ones with more 0s) by from_chars; decimal mantissas of up
+    // to MAX_DECIMAL_DIGITS digits fit the 64 bit accumulator
+    constexpr std::size_t MAX_DECIMAL_DIGITS = 18;
+    constexpr std::size_t MAX_LONG_DIGITS = std::numeric_limits<long>::digits10;
+    constexpr std::size_t MAX_HEX_DIGITS = std::numeric_limits<long>::digits / 4;
+
+    constexpr std::uint64_t POWERS_OF_10[] = {
+        1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+        10000000ull, 100000000ull
+    };
+
+    // exactly representable as a double
+    constexpr double DOUBLE_POWERS_OF_10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    unsigned first_byte(std::uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward64(&idx, mask);
+        return (unsigned)idx / 8;
+#else
+        return (unsigned)__builtin_ctzll(mask) / 8;
+#endif
+    }
 
-bool number_parser::is_binary(const char* text, std::ptrdiff_t length)
-{
-    // e.g.: 0b00101010
-    return (length > 2) && // '0b'
-        (*text == '0') &&
-        (*(text + 1) == 'b');
-}
+    // the high bit of every byte of word that is at least c,
+    // the bytes of word must all be below 0x80
+    constexpr std::uint64_t bytes_at_least(std::uint64_t word, unsigned char c)
+    {
+        return ((word | SWAR_HIGH) - c * SWAR_ONES) & SWAR_HIGH;
+    }
 
-number_parser::InternalNumberType number_parser::get_number_type(const char* text, std::ptrdiff_t length)
-{
-    const char* begin_ptr = text;
-    const char* end_ptr = text + length - 1;
+    // the high bit of every byte of word that is not in [lo, hi]
+    constexpr std::uint64_t bytes_outside(std::uint64_t word, unsigned char lo, unsigned char hi)
+    {
+        const std::uint64_t low = word & ~SWAR_HIGH;
+        const std::uint64_t inside = bytes_at_least(low, lo) & ~bytes_at_least(low, hi + 1) & ~word;
+        return ~inside & SWAR_HIGH;
+    }
+
+    // moves the first count characters to the end of the word
+    // and fills the start with '0', count must be at least 1
+    std::uint64_t align_digits(std::uint64_t word, unsigned count)
+    {
+        return (count == 8) ? word : (word << (8 * (8 - count))) | (SWAR_ZEROS >> (8 * count));
+    }
+
+    // 8 decimal digits, the first one in the lowest byte
+    std::uint64_t eight_decimal_digits(std::uint64_t word)
+    {
+        word -= SWAR_ZEROS;
+        word = (word * 10) + (word >> 8);
+        word = (((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+            (((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+
+        return word;
+    }
 
-    if (is_hexadecimal(text, length))
+    // 8 hexadecimal digits of either case, the first one in the lowest byte
+    std::uint64_t eight_hex_digits(std::uint64_t word)
     {
-        begin_ptr += 2; // skip '0x'
-        static const char* special_chars = "ABCDEFabcdef";
+        const std::uint64_t letters = bytes_at_least(word, 'A') >> 7; // 1 per letter
+        word = (word & (0x0F * SWAR_ONES)) + (letters * 9);
 
-        // consume all characters, but if a character
-        // is not a digit or a part of special characters
-        // then it is not a valid hexadecimal number
-        while (begin_ptr < end_ptr)
+        // pairs of nibbles into bytes, then bytes into 16 and 32 bits
+        word = ((word << 4) | (word >> 8)) & 0x00FF00FF00FF00FFull;
+        word = ((word << 8) | (word >> 16)) & 0x0000FFFF0000FFFFull;
+        word = ((word << 16) | (word >> 32)) & 0x00000000FFFFFFFFull;
+
+        return word;
+    }
+
+    // reads the digits from ptr on, 8 at a time while a word fits before
+    // end_ptr; value holds them while there are at most max_digits,
+    // digits counts all of them
+    template <bool Hex>
+    const char* read_digits(const char* ptr, const char* end_ptr,
+        std::uint64_t& value, std::size_t& digits, std::size_t max_digits)
+    {
+        while (end_ptr - ptr >= 8)
         {
-            if (!isdigit(*begin_ptr) && !strchr(special_chars, *begin_ptr))
+            std::uint64_t word;
+            memcpy(&word, ptr, 8);
+
+            std::uint64_t stop;
+            if (Hex)
             {
-                return InternalNumberType::NUMBER_NUM;
+                // letters are folded to lowercase, digits stay as they are
+                stop = bytes_outside(word, '0', '9') & bytes_outside(word | (0x20 * SWAR_ONES), 'a', 'f');
+            }
+            else
+            {
+                stop = bytes_outside(word, '0', '9');
             }
 
-            ++begin_ptr;
-        }
+            const unsigned count = (stop != 0) ? first_byte(stop) : 8;
+            if (count == 0)
+            {
+                break;
+            }
 
-        return InternalNumberType::NUMBER_HEXADECIMAL;
-    }
-    else if (is_binary(text, length))
-    {
-        begin_ptr += 2; // skip '0b'
+            if (digits + count <= max_digits)
+            {
+                const std::uint64_t chunk = align_digits(word, count);
+                value = Hex ?
+                    ((value << (4 * count)) | eight_hex_digits(chunk)) :
+                    (value * POWERS_OF_10[count]) + eight_decimal_digits(chunk);
+            }
+
+            digits += count;
+            ptr += count;
+
+            if (count < 8)
+            {
+                return ptr;
+            }
+        }
 
-        // a binary number should have
-        // only '1's and '0's
-        while (begin_ptr < end_ptr)
+        // the last few are not worth a word
+        for (; ptr < end_ptr; ++ptr)
         {
-            if ((*begin_ptr != '0') && (*begin_ptr != '1'))
+            const char c = *ptr;
+            unsigned digit;
+            if (is_digit(c))
             {
-                return InternalNumberType::NUMBER_NUM;
+                digit = (unsigned)(c - '0');
+            }
+            else if (Hex && is_digit_or_hex(c))
+            {
+                digit = (unsigned)((c | 0x20) - 'a' + 10);
+            }
+            else
+            {
+                break;
             }
 
-            ++begin_ptr;
+            if (++digits <= max_digits)
+            {
+                value = Hex ? ((value << 4) | digit) : (value * 10) + digit;
+            }
         }
 
-        return InternalNumberType::NUMBER_BINARY;
+        return ptr;
+    }
+#endif
+} // anonymous
+
+bool number_parser::parse_integer(const char* begin_ptr, const char* end_ptr, int base)
+{
+    // digits are classified and converted in the same
+    // pass, a sign must be handled by the caller
+    long value = 0;
+    const auto result = std::from_chars(begin_ptr, end_ptr, value, base);
+
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        m_overflow = true;
+        return false;
     }
-    else if (is_octal(text, length))
+
+    if ((result.ec != std::errc()) || (result.ptr != end_ptr))
     {
-        static const char* valid_characters = "01234567";
+        return false;
+    }
 
-        // only digits from 0 to 7 are valid
-        while (begin_ptr < end_ptr)
-        {
-            if (!strchr(valid_characters, *begin_ptr))
-            {
-                return InternalNumberType::NUMBER_NUM;
-            }
+    m_number.type = NumberType::NUMBER_LONG;
+    m_number.nb.l = value;
 
-            ++begin_ptr;
-        }
+    return true;
+}
+
+bool number_parser::parse_double(const char* begin_ptr, const char* end_ptr)
+{
+    double value = 0.0;
+    const auto result = std::from_chars(begin_ptr, end_ptr, value);
+
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        m_overflow = true;
+        return false;
+    }
+
+    if ((result.ec != std::errc()) || (result.ptr != end_ptr))
+    {
+        return false;
+    }
 
-        return InternalNumberType::NUMBER_OCTAL;
+    m_number.type = NumberType::NUMBER_DOUBLE;
+    m_number.nb.d = value;
+
+    return true;
+}
+
+bool number_parser::parse(const char* text, std::ptrdiff_t length)
+{
+    m_overflow = false;
+    if (length <= 0)
+    {
+        return false;
     }
-    else if (is_decimal(text, length))
+
+    const char* end_ptr = text + length;
+
+    // e.g.: 0xA1B2C3
+    if ((length > 2) && (text[0] == '0') && (text[1] == 'x'))
     {
-        // a decimal number can start with '+' or '-'
-        if ((*text == '+') || (*text == '-'))
+        if (!is_digit_or_hex(text[2]))
         {
-            begin_ptr += 1; // skip '+' or '-'
+            return false;
         }
 
-        // consume all available digits
-        while ((begin_ptr < end_ptr) && isdigit(*begin_ptr))
+#ifdef CP_HAS_SWAR_DIGITS
+        std::uint64_t value = 0;
+        std::size_t digits = 0;
+        if ((read_digits<true>(text + 2, end_ptr, value, digits, MAX_HEX_DIGITS) == end_ptr) &&
+            (digits <= MAX_HEX_DIGITS))
         {
-            ++begin_ptr;
+            m_number.type = NumberType::NUMBER_LONG;
+            m_number.nb.l = (long)value;
+            return true;
         }
+#endif
 
-        // if a dot is encountered, check if it's
-        // a valid floating point number
-        if (*begin_ptr == '.')
-        {
-            // consume dot
-            ++begin_ptr;
+        return parse_integer(text + 2, end_ptr, 16);
+    }
 
-            // consume all available digits
-            while ((begin_ptr < end_ptr) && isdigit(*begin_ptr))
-            {
-                ++begin_ptr;
-            }
+    // e.g.: 0b00101010
+    if ((length > 2) && (text[0] == '0') && (text[1] == 'b'))
+    {
+        return is_digit(text[2]) && parse_integer(text + 2, end_ptr, 2);
+    }
 
-            // if 'E' or 'e' is encountered, then
-            // it's still a valid number so the check continues
-            if ((*begin_ptr == 'E') || (*begin_ptr == 'e'))
-            {
-                ++begin_ptr;
-
-                // check if 'E' or 'e' is followed
-                // by '+' or '-' and consume it
-                if ((*begin_ptr == '+') ||
-                    (*begin_ptr == '-'))
-                {
-                    ++begin_ptr;
-                }
-
-                // after 'E', 'e', '+' or '-' at least
-                // one more digit is required
-                if (!isdigit(*begin_ptr))
-                {
-                    return InternalNumberType::NUMBER_NUM;
-                }
-
-                // continue consuming digits until the end
-                while ((begin_ptr < end_ptr) && (isdigit(*begin_ptr)))
-                {
-                    ++begin_ptr;
-                }
-            }
+    // e.g.: 01337, so a double can not start with '0'
+    if ((length > 1) && (text[0] == '0'))
+    {
+        return parse_integer(text, end_ptr, 8);
+    }
+
+    // a decimal number can start with '+' or '-',
+    // but from_chars only accepts the latter
+    const char* begin_ptr = text;
+    const char* digits_ptr = text;
+    if ((*text == '+') || (*text == '-'))
+    {
+        ++digits_ptr;
+        begin_ptr = (*text == '+') ? digits_ptr : text;
+    }
+    else if (!is_digit(*text))
+    {
+        return false;
+    }
+
+#ifdef CP_HAS_SWAR_DIGITS
+    // the common cases are converted here, the
+    // others are left to the checks below
+    std::uint64_t value = 0;
+    std::size_t digits = 0;
+    const char* current_ptr = read_digits<false>(digits_ptr, end_ptr, value, digits, MAX_DECIMAL_DIGITS);
+
+    if ((current_ptr == end_ptr) && (digits != 0) && (digits <= MAX_LONG_DIGITS))
+    {
+        m_number.type = NumberType::NUMBER_LONG;
+        m_number.nb.l = (*text == '-') ? -(long)value : (long)value;
+        return true;
+    }
+
+#if FLT_EVAL_METHOD == 0
+    // e.g. 12.375: an integer mantissa of at most 53 bits divided by
+    // a power of 10 that is a double itself is rounded correctly
+    if ((current_ptr < end_ptr) && (*current_ptr == '.') && (digits != 0) && (digits <= MAX_DECIMAL_DIGITS))
+    {
+        std::size_t fraction_digits = 0;
+        const char* fraction_ptr = read_digits<false>(current_ptr + 1, end_ptr, value,
+            fraction_digits, MAX_DECIMAL_DIGITS - digits);
 
-            // if another non-digit character is encountered
-            // then it's an unknown number format
-            return (begin_ptr < end_ptr)
-                ? InternalNumberType::NUMBER_NUM
-                : InternalNumberType::NUMBER_DOUBLE;
+        if ((fraction_ptr == end_ptr) && (fraction_digits != 0) &&
+            (digits + fraction_digits <= MAX_DECIMAL_DIGITS) && (value <= (1ull << 53)))
+        {
+            const double d = (double)value / DOUBLE_POWERS_OF_10[fraction_digits];
+            m_number.type = NumberType::NUMBER_DOUBLE;
+            m_number.nb.d = (*text == '-') ? -d : d;
+            return true;
         }
+    }
+#endif
 
-        // no dot encountered, so it can be an integer
-        return (begin_ptr < end_ptr)
-            ? InternalNumberType::NUMBER_NUM
-            : InternalNumberType::NUMBER_INTEGER;
+    if (current_ptr == end_ptr)
+    {
+        return (digits != 0) && parse_integer(begin_ptr, end_ptr, 10);
+    }
+#else
+    const char* current_ptr = digits_ptr;
+    while ((current_ptr < end_ptr) && is_digit(*current_ptr))
+    {
+        ++current_ptr;
     }
 
-    // unknown number format
-    return InternalNumberType::NUMBER_NUM;
-}
+    if (current_ptr == end_ptr)
+    {
+        return (current_ptr != digits_ptr) && parse_integer(begin_ptr, end_ptr, 10);
+    }
+#endif
 
-bool number_parser::parse_binary(const char* text, std::ptrdiff_t length)
-{
-    return parse_integer_base(m_number, text, length, 2);
-}
+    // a floating point number needs a dot, the exponent is
+    // optional and needs at least one digit, e.g.: -1.5e+3
+    if (*current_ptr != '.')
+    {
+        return false;
+    }
 
-bool number_parser::parse_hexadecimal(const char* text, std::ptrdiff_t length)
-{
-    return parse_integer_base(m_number, text, length, 16);
-}
+    ++current_ptr;
+    while ((current_ptr < end_ptr) && is_digit(*current_ptr))
+    {
+        ++current_ptr;
+    }
 
-bool number_parser::parse_integer(const char* text, std::ptrdiff_t length)
-{
-    return parse_integer_base(m_number, text, length, 10);
-}
+    if ((current_ptr < end_ptr) && ((*current_ptr == 'E') || (*current_ptr == 'e')))
+    {
+        ++current_ptr;
+        if ((current_ptr < end_ptr) && ((*current_ptr == '+') || (*current_ptr == '-')))
+        {
+            ++current_ptr;
+        }
 
-bool number_parser::parse_octal(const char* text, std::ptrdiff_t length)
-{
-    return parse_integer_base(m_number, text, length, 8);
-}
+        if ((current_ptr == end_ptr) || !is_digit(*current_ptr))
+        {
+            return false;
+        }
 
-bool number_parser::parse_double(const char* text, std::ptrdiff_t length)
-{
-    // let everything to std?
-    char* end_ptr = nullptr;
-    m_number.nb.d = std::strtod(text, &end_ptr);
-    m_number.type = NumberType::NUMBER_DOUBLE;
+        while ((current_ptr < end_ptr) && is_digit(*current_ptr))
+        {
+            ++current_ptr;
+        }
+    }
 
-    return end_ptr == (text + length);
+    return (current_ptr == end_ptr) && parse_double(begin_ptr, end_ptr);
 }
 
-bool number_parser::parse(const char* text, std::ptrdiff_t length)
+bool number_parser::overflow() const
 {
-    const auto number_type = get_number_type(text, length);
-    switch (number_type)
-    {
-        case InternalNumberType::NUMBER_BINARY:
-            return parse_binary(text + 2, length - 2);
-        case InternalNumberType::NUMBER_HEXADECIMAL:
-            return parse_hexadecimal(text, length);
-        case InternalNumberType::NUMBER_OCTAL:
-            return parse_octal(text, length);
-        case InternalNumberType::NUMBER_INTEGER:
-            return parse_integer(text, length);
-        case InternalNumberType::NUMBER_DOUBLE:
-            return parse_double(text, length);
-        default:
-            return false;
-    }
+    return m_overflow;
 }
 
 const number& number_parser::get() const
@@ -284,35 +452,87 @@ const number& number_parser::get() const
     return m_number;
 }
 
-bool boolean_parser::is_true(const char* text, std::ptrdiff_t length)
+namespace
 {
-    if (length == 1)
+    char to_lower(char c)
     {
-        return (*text == 'y') ||
-            (*text == 't');
+        return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
     }
-    else
+
+    // word must be lowercase
+    bool equals_folded(const char* text, std::string_view word)
     {
-        if (_strcmpi("on", text) == 0) return true;
-        if (_strcmpi("yes", text) == 0) return true;
-        if (_strcmpi("enabled", text) == 0) return true;
+        for (size_t i = 0; i < word.size(); ++i)
+        {
+            if (to_lower(text[i]) != word[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
+} // anonymous
 
-    return false;
+std::shared_ptr<const boolean_words> add_boolean_word(
+    const std::shared_ptr<const boolean_words>& words, std::string_view word, bool value)
+{
+    boolean_word entry{ std::string(word), value };
+    for (char& c : entry.word)
+    {
+        c = to_lower(c);
+    }
+
+    // parsers and their copies may be sharing the current list
+    auto copy = (words != nullptr) ?
+        std::make_shared<boolean_words>(*words) :
+        std::make_shared<boolean_words>();
+
+    copy->push_back(std::move(entry));
+
+    return copy;
+}
+
+boolean_parser::boolean_parser(const boolean_words* words) noexcept
+    : m_words(words)
+{
 }
 
-bool boolean_parser::is_false(const char* text, std::ptrdiff_t length)
+bool boolean_parser::parse_builtin(const char* text, std::ptrdiff_t length)
 {
-    if (length == 1)
+    // single characters are case sensitive,
+    // whole words are not
+    switch (length)
     {
-        return (*text == 'n') ||
-            (*text == 'f');
+        case 1:
+            m_boolean = (*text == 'y') || (*text == 't');
+            return m_boolean || (*text == 'n') || (*text == 'f');
+        case 2:
+            m_boolean = equals_folded(text, "on");
+            return m_boolean || equals_folded(text, "no");
+        case 3:
+            m_boolean = equals_folded(text, "yes");
+            return m_boolean || equals_folded(text, "off");
+        case 7:
+            m_boolean = equals_folded(text, "enabled");
+            return m_boolean;
+        case 8:
+            m_boolean = false;
+            return equals_folded(text, "disabled");
+        default:
+            return false;
     }
-    else
+}
+
+bool boolean_parser::parse_user(const char* text, std::ptrdiff_t length)
+{
+    for (const boolean_word& w : *m_words)
     {
-        if (_strcmpi("off", text) == 0) return true;
-        if (_strcmpi("no", text) == 0) return true;
-        if (_strcmpi("disabled", text) == 0) return true;
+        if ((w.word.size() == (size_t)length) && equals_folded(text, w.word))
+        {
+            m_boolean = w.value;
+            return true;
+        }
     }
 
     return false;
@@ -320,13 +540,13 @@ bool boolean_parser::is_false(const char* text, std::ptrdiff_t length)
 
 bool boolean_parser::parse(const char* text, std::ptrdiff_t length)
 {
-    std::string str;
-    str.reserve(length);
-    str.assign(text, length);
-
-    m_boolean = is_true(str.c_str(), length);
+    if (parse_builtin(text, length))
+    {
+        return true;
+    }
 
-    return m_boolean || is_false(str.c_str(), length);
+    // a single check when there are no extra words
+    return (m_words != nullptr) && parse_user(text, length);
 }
 
 bool boolean_parser::get() const
@@ -1,16 +1,14 @@
 #include "value_type.h"
+#include "value_parser.h"
+#include "utils.h"
 #include <cassert> // assert
+#include <stdexcept> // length_error, logic_error
+#include <thread> // yield
 
 namespace configparser
 {
 
-detail::value_union::value_union()
-{
-}
-
-detail::value_union::~value_union()
-{
-}
+static_assert(sizeof(value_type) == 16, "value_type is meant to stay compact");
 
 value_type::value_type(long val)
     : m_type(ValueType::VALUE_LONG)
@@ -33,79 +31,90 @@ value_type::value_type(bool val)
 value_type::value_type(std::string&& val)
     : m_type(ValueType::VALUE_STRING)
 {
-    new (&m_value.str) std::string();
-    m_value.str = std::move(val);
+    m_value.str = new detail::shared_string(std::move(val));
 }
 
-value_type::value_type(const value_type& other)
-    : m_type(other.m_type)
+value_type value_type::from_view(std::string_view val)
 {
-    switch (m_type)
+    if (val.size() > MAX_BORROWED_SIZE)
     {
-        case ValueType::VALUE_LONG:
-            m_value.l = other.m_value.l;
-            break;
-        case ValueType::VALUE_DOUBLE:
-            m_value.d = other.m_value.d;
-            break;
-        case ValueType::VALUE_BOOLEAN:
-            m_value.b = other.m_value.b;
-            break;
-        case ValueType::VALUE_STRING:
-            new (&m_value.str) std::string();
-            m_value.str = other.m_value.str;
-            break;
-        default: // should never happen
-            break;
+        throw std::length_error("configparser: borrowed string too long");
     }
+
+    value_type value;
+    value.m_type = ValueType::VALUE_STRING;
+    value.m_borrowed = true;
+    value.m_value.ptr = val.data();
+    value.m_size = (std::uint32_t)val.size();
+
+    return value;
 }
 
-value_type::value_type(value_type&& other) noexcept
-    : m_type(other.m_type)
+value_type value_type::from_raw(std::string_view raw, bool borrow_str)
+{
+    if (raw.size() > MAX_BORROWED_SIZE)
+    {
+        throw std::length_error("configparser: raw value too long");
+    }
+
+    // until typed, the value holds the raw text
+    // and m_borrowed whether it may be borrowed
+    value_type value;
+    value.m_value.ptr = raw.data();
+    value.m_size = (std::uint32_t)raw.size();
+    value.m_borrowed = borrow_str;
+    value.m_state.store(LazyState::LAZY_PENDING, std::memory_order_relaxed);
+
+    return value;
+}
+
+value_type value_type::from_shared(detail::shared_string* str)
+{
+    str->refs.fetch_add(1, std::memory_order_relaxed);
+
+    value_type value;
+    value.m_type = ValueType::VALUE_STRING;
+    value.m_value.str = str;
+
+    return value;
+}
+
+value_type::value_type(const value_type& other)
 {
-    switch (m_type)
+    // a pending value is copied as pending
+    if (other.lock_pending())
     {
-        case ValueType::VALUE_LONG:
-            m_value.l = other.m_value.l;
-            break;
-        case ValueType::VALUE_DOUBLE:
-            m_value.d = other.m_value.d;
-            break;
-        case ValueType::VALUE_BOOLEAN:
-            m_value.b = other.m_value.b;
-            break;
-        case ValueType::VALUE_STRING:
-            new (&m_value.str) std::string();
-            m_value.str = std::move(other.m_value.str);
-            break;
-        default: // should never happen
-            break;
+        copy_from(other, LazyState::LAZY_PENDING);
+        other.unlock_pending();
+        return;
     }
+
+    copy_from(other, LazyState::LAZY_RESOLVED);
+}
+
+value_type::value_type(value_type&& other) noexcept
+    : m_value(other.m_value)
+    , m_size(other.m_size)
+    , m_type(other.m_type)
+    , m_borrowed(other.m_borrowed)
+    , m_state(other.m_state.load(std::memory_order_relaxed))
+{
+    // moving needs exclusive access to other, which already
+    // orders it after any thread that typed it
+    // the moved value no longer owns a string
+    other.m_type = ValueType::VALUE_NUM;
+    other.m_borrowed = false;
+    other.m_state.store(LazyState::LAZY_RESOLVED, std::memory_order_relaxed);
 }
 
 value_type& value_type::operator=(const value_type& other)
 {
     if (this != &other)
     {
-        m_type = other.m_type;
-        switch (m_type)
-        {
-            case ValueType::VALUE_LONG:
-                m_value.l = other.m_value.l;
-                break;
-            case ValueType::VALUE_DOUBLE:
-                m_value.d = other.m_value.d;
-                break;
-            case ValueType::VALUE_BOOLEAN:
-                m_value.b = other.m_value.b;
-                break;
-            case ValueType::VALUE_STRING:
-                new (&m_value.str) std::string();
-                m_value.str = other.m_value.str;
-                break;
-            default: // should never happen
-                break;
-        }
+        // the string of this value may be the one of other,
+        // so it is released only after sharing it again
+        value_type copy(other);
+        *this = std::move(copy);
     }
 
     return *this;
@@ -115,25 +124,17 @@ value_type& value_type::operator=(value_type&& other) noexcept
 {
     if (this != &other)
     {
+        release();
+
+        m_value = other.m_value;
+        m_size = other.m_size;
         m_type = other.m_type;
-        switch (m_type)
-        {
-            case ValueType::VALUE_LONG:
-                m_value.l = other.m_value.l;
-                break;
-            case ValueType::VALUE_DOUBLE:
-                m_value.d = other.m_value.d;
-                break;
-            case ValueType::VALUE_BOOLEAN:
-                m_value.b = other.m_value.b;
-                break;
-            case ValueType::VALUE_STRING:
-                new (&m_value.str) std::string();
-                m_value.str = std::move(other.m_value.str);
-                break;
-            default: // should never happen
-                break;
-        }
+        m_borrowed = other.m_borrowed;
+        m_state.store(other.m_state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        other.m_type = ValueType::VALUE_NUM;
+        other.m_borrowed = false;
+        other.m_state.store(LazyState::LAZY_RESOLVED, std::memory_order_relaxed);
     }
 
     return *this;
@@ -141,44 +142,194 @@ value_type& value_type::operator=(value_type&& other) noexcept
 
 value_type::~value_type()
 {
-    if (m_type == ValueType::VALUE_STRING)
+    release();
+}
+
+void value_type::copy_from(const value_type& other, LazyState state)
+{
+    m_value = other.m_value;
+    m_size = other.m_size;
+    m_type = other.m_type;
+    m_borrowed = other.m_borrowed;
+    m_state.store(state, std::memory_order_relaxed);
+
+    if ((state == LazyState::LAZY_RESOLVED) && (m_type == ValueType::VALUE_STRING) && !m_borrowed)
+    {
+        m_value.str->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void value_type::release()
+{
+    // a pending value only borrows its raw text
+    if ((m_state.load(std::memory_order_relaxed) == LazyState::LAZY_RESOLVED) &&
+        (m_type == ValueType::VALUE_STRING) && !m_borrowed)
+    {
+        if (m_value.str->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete m_value.str;
+        }
+    }
+
+    m_type = ValueType::VALUE_NUM;
+}
+
+std::string_view value_type::raw() const
+{
+    return { m_value.ptr, m_size };
+}
+
+bool value_type::lock_pending() const
+{
+    // a pending value is locked like while it is being typed,
+    // so its raw text is not overwritten while being copied
+    LazyState state = m_state.load(std::memory_order_acquire);
+    while (state != LazyState::LAZY_RESOLVED)
+    {
+        if ((state == LazyState::LAZY_PENDING) &&
+            m_state.compare_exchange_weak(state, LazyState::LAZY_RESOLVING, std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        if (state == LazyState::LAZY_RESOLVING)
+        {
+            std::this_thread::yield();
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+    return false;
+}
+
+void value_type::unlock_pending() const
+{
+    m_state.store(LazyState::LAZY_PENDING, std::memory_order_release);
+}
+
+void value_type::resolve() const
+{
+    // the first reader types the value, the
+    // others wait until it is published
+    if (lock_pending())
     {
-        m_value.str.~basic_string();
+        classify();
+        m_state.store(LazyState::LAZY_RESOLVED, std::memory_order_release);
     }
 }
 
+void value_type::classify() const
+{
+    // same order as ConfigParser::parse_value(), links
+    // and the extra boolean words of the parser are
+    // always handled while parsing
+    const std::string_view raw = this->raw();
+    const bool borrow_str = m_borrowed;
+
+    detail::boolean_parser bp;
+    if (bp.parse(raw.data(), (std::ptrdiff_t)raw.size()))
+    {
+        m_value.b = bp.get();
+        m_type = ValueType::VALUE_BOOLEAN;
+        return;
+    }
+
+    detail::number_parser np;
+    if (np.parse(raw.data(), (std::ptrdiff_t)raw.size()))
+    {
+        switch (np.get().type)
+        {
+            case detail::NumberType::NUMBER_LONG:
+                m_value.l = np.get().nb.l;
+                m_type = ValueType::VALUE_LONG;
+                return;
+            case detail::NumberType::NUMBER_DOUBLE:
+                m_value.d = np.get().nb.d;
+                m_type = ValueType::VALUE_DOUBLE;
+                return;
+            default: // should NEVER get here
+                assert(false);
+                break;
+        }
+    }
+
+    if (borrow_str && (raw.find('\\') == std::string_view::npos))
+    {
+        m_borrowed = true; // the text is already in place
+    }
+    else
+    {
+        m_value.str = new detail::shared_string(detail::remove_escapes(std::string{ raw }));
+        m_borrowed = false;
+    }
+
+    m_type = ValueType::VALUE_STRING;
+}
+
 ValueType value_type::type() const
 {
+    resolve();
     return m_type;
 }
 
 bool value_type::has_type(ValueType type) const
 {
+    resolve();
     return m_type == type;
 }
 
 long value_type::to_long() const
 {
+    resolve();
     assert(has_type(ValueType::VALUE_LONG));
     return m_value.l;
 }
 
 double value_type::to_double() const
 {
+    resolve();
     assert(has_type(ValueType::VALUE_DOUBLE));
     return m_value.d;
 }
 
 bool value_type::to_bool() const
 {
+    resolve();
     assert(has_type(ValueType::VALUE_BOOLEAN));
     return m_value.b;
 }
 
 const std::string& value_type::to_str() const
 {
+    resolve();
     assert(has_type(ValueType::VALUE_STRING));
-    return m_value.str;
+
+    // there is no std::string to refer to, and making one here
+    // would race with other threads reading the same value
+    if (m_borrowed)
+    {
+        throw std::logic_error("configparser: borrowed string, use to_view()");
+    }
+
+    return m_value.str->str;
+}
+
+std::string_view value_type::to_view() const
+{
+    resolve();
+    assert(has_type(ValueType::VALUE_STRING));
+    return m_borrowed ? raw() : std::string_view(m_value.str->str);
+}
+
+bool value_type::is_borrowed() const
+{
+    resolve(); // before that, m_borrowed has another meaning
+    return m_borrowed;
+}
+
+bool value_type::is_resolved() const
+{
+    return m_state.load(std::memory_order_acquire) == LazyState::LAZY_RESOLVED;
 }
 
 } // configparser
@@ -0,0 +1,61 @@
+#include "check.h"
+#include <batch.h>
+#include <configparser.h>
+#include <string>
+#include <vector>
+
+using namespace configparser;
+
+namespace
+{
+    const char* const TEXT =
+        "[a]\n"
+        "yes = JA\n"
+        "no = nein\n"
+        "builtin = off\n";
+
+    bool is_boolean(const ConfigParser& p, const char* option, bool value)
+    {
+        const value_type& val = p.option("a", option).values()[0];
+        return val.has_type(ValueType::VALUE_BOOLEAN) && (val.to_bool() == value);
+    }
+
+    void check_words(ValueMode value_mode)
+    {
+        ConfigParser p;
+        p.set_value_mode(value_mode);
+        p.add_boolean_word("ja", true);
+        p.add_boolean_word("Nein", false);
+        CP_CHECK(p.parse_text(TEXT));
+        CP_CHECK(is_boolean(p, "yes", true));
+        CP_CHECK(is_boolean(p, "no", false));
+        CP_CHECK(is_boolean(p, "builtin", false));
+
+        // the words belong to the parser that has them
+        ConfigParser other;
+        other.set_value_mode(value_mode);
+        CP_CHECK(other.parse_text(TEXT));
+        CP_CHECK(other.option("a", "yes").values()[0].has_type(ValueType::VALUE_STRING));
+        CP_CHECK(is_boolean(other, "builtin", false));
+
+        // a copy shares them, a change to it does not
+        ConfigParser copy = p;
+        copy.clear_boolean_words();
+        CP_CHECK(copy.parse_text(TEXT));
+        CP_CHECK(copy.option("a", "no").values()[0].has_type(ValueType::VALUE_STRING));
+        CP_CHECK(p.parse_text(TEXT));
+        CP_CHECK(is_boolean(p, "no", false));
+
+        // and they are handed on to the parsers of a batch
+        const std::vector<batch_result> results = parse_batch({ batch_input::from_text("a", TEXT) }, p, 1);
+        CP_CHECK(results[0].ok && is_boolean(results[0].parser, "yes", true));
+    }
+} // anonymous
+
+int main()
+{
+    check_words(ValueMode::VALUE_EAGER);
+    check_words(ValueMode::VALUE_LAZY);
+
+    return test::result();
+}
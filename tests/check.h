@@ -0,0 +1,37 @@
+#ifndef CP_TESTS_CHECK_H
+#define CP_TESTS_CHECK_H
+
+#include <cstdio>
+
+namespace configparser
+{
+namespace test
+{
+    inline int g_failures = 0;
+
+    inline void check(bool ok, const char* expr, const char* file, int line)
+    {
+        if (!ok)
+        {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+            ++g_failures;
+        }
+    }
+
+    // the exit status of a test
+    inline int result()
+    {
+        if (g_failures != 0)
+        {
+            std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        }
+
+        return (g_failures == 0) ? 0 : 1;
+    }
+} // test
+} // configparser
+
+// a failed check is reported and the test goes on
+#define CP_CHECK(expr) ::configparser::test::check((expr), #expr, __FILE__, __LINE__)
+
+#endif // CP_TESTS_CHECK_H
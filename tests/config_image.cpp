@@ -0,0 +1,220 @@
+#include "check.h"
+#include <config_image.h>
+#include <cstdio> // remove
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace configparser;
+
+namespace
+{
+    const char* const TEXT =
+        "[server]\n"
+        "host = example.org\n"
+        "port = 8080\n"
+        "ratio = 1.5\n"
+        "secure = on\n"
+        "flag = ja\n"
+        "padded = \\ spaced\\ \n"
+        "[server]\n"
+        "host = duplicate.org\n"
+        "[lists]\n"
+        "ports = 1, 2, 3, 4\n"
+        "names = a, b, c\n"
+        "copy = ${server#port}\n"
+        "[empty]\n";
+
+    const char* const SOURCE = "config_image_test.ini";
+    const char* const IMAGE = "config_image_test.img";
+
+    void write_file(const char* filename, const std::string& data)
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out.write(data.data(), (std::streamsize)data.size());
+    }
+
+    std::string read_file(const char* filename)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        return { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    }
+
+    // the image answers every query like the parser it was written from
+    bool same_values(const option_type& opt, const image_option& img)
+    {
+        if ((img.name() != opt.name()) || (img.size() != opt.size()))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < opt.size(); ++i)
+        {
+            const ValueType type = opt.get_type(i);
+            if (img.get_type(i) != type)
+            {
+                return false;
+            }
+
+            const bool same =
+                (type == ValueType::VALUE_LONG) ? (img.get<long>(i) == opt.get<long>(i)) :
+                (type == ValueType::VALUE_DOUBLE) ? (img.get<double>(i) == opt.get<double>(i)) :
+                (type == ValueType::VALUE_BOOLEAN) ? (img.get<bool>(i) == opt.get<bool>(i)) :
+                (img.get<std::string_view>(i) == opt.get_view(i));
+
+            if (!same)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void check_round_trip(const ConfigParser& p, bool verify_checksum)
+    {
+        config_image image;
+        CP_CHECK(config_image::write(p, IMAGE, config_image::hash_source(TEXT)));
+        CP_CHECK(image.open(IMAGE, verify_checksum));
+        CP_CHECK(image.source_hash() == config_image::hash_source(TEXT));
+        CP_CHECK(image.sections().size() == p.sections().size());
+
+        for (size_t s = 0; s < p.sections().size(); ++s)
+        {
+            const section_type& sct = p.sections()[s];
+            const image_section img = image.sections()[s];
+            CP_CHECK(img.name() == sct.name());
+            CP_CHECK(img.options().size() == sct.options().size());
+            for (size_t o = 0; o < sct.options().size(); ++o)
+            {
+                CP_CHECK(same_values(sct.options()[o], img.options()[o]));
+            }
+        }
+
+        // lookups find the first of duplicate names, like the parser
+        for (const section_type& sct : p.sections())
+        {
+            for (const option_type& opt : p.options(sct.name()))
+            {
+                const std::optional<image_option> img = image.find_option(sct.name(), opt.name());
+                CP_CHECK(img.has_value() && same_values(p.option(sct.name(), opt.name()), *img));
+            }
+        }
+
+        CP_CHECK(image.option("server", "host").get<std::string_view>() == "example.org");
+        CP_CHECK(image.option("lists", "copy").get<long>() == 8080);
+        CP_CHECK(image.has_section("empty") && image.get_section("empty").options().empty());
+        CP_CHECK(!image.has_section("missing"));
+        CP_CHECK(!image.has_option("server", "missing"));
+        CP_CHECK(!image.find_option(option_key("lists", "missing")).has_value());
+
+        bool thrown = false;
+        try
+        {
+            (void)image.option("server", "missing");
+        }
+        catch (const std::out_of_range&)
+        {
+            thrown = true;
+        }
+
+        CP_CHECK(thrown);
+    }
+
+    // compiling takes every setting of the parser
+    void check_compile()
+    {
+        write_file(SOURCE, TEXT);
+
+        ConfigParser settings;
+        settings.add_boolean_word("ja", true);
+        settings.set_value_mode(ValueMode::VALUE_LAZY);
+        CP_CHECK(config_image::compile(SOURCE, IMAGE, settings));
+
+        config_image image;
+        CP_CHECK(image.open(IMAGE));
+        CP_CHECK(image.option("server", "flag").get_type() == ValueType::VALUE_BOOLEAN);
+        CP_CHECK(!image.is_stale(SOURCE));
+
+        settings.set_number_mode(NumberMode::NUMBER_STRICT);
+        write_file(SOURCE, "[a]\nbig = 99999999999999999999\n");
+        CP_CHECK(image.is_stale(SOURCE));
+        CP_CHECK(!config_image::compile(SOURCE, IMAGE, settings));
+
+        std::remove(SOURCE);
+    }
+
+    // reads whatever a damaged image that was accepted points to
+    void read_all(const config_image& image)
+    {
+        for (const image_section sct : image.sections())
+        {
+            (void)image.find_section(sct.name());
+            for (const image_option opt : sct.options())
+            {
+                (void)sct.find_option(opt.name());
+                for (const image_value val : opt.values())
+                {
+                    if (val.type() == ValueType::VALUE_STRING)
+                    {
+                        (void)val.to_view();
+                    }
+                }
+            }
+        }
+
+        (void)image.find_option("server", "host");
+        (void)image.find_option("lists", "missing");
+    }
+
+    // without the checksum a damaged image is either rejected or
+    // read within its bounds (which the sanitizers tell apart)
+    void check_damaged(const ConfigParser& p)
+    {
+        CP_CHECK(config_image::write(p, IMAGE));
+        const std::string data = read_file(IMAGE);
+
+        config_image image;
+        for (size_t size = 0; size < data.size(); size += 8)
+        {
+            write_file(IMAGE, data.substr(0, size));
+            CP_CHECK(!image.open(IMAGE, false));
+        }
+
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            for (const char bits : { '\x01', '\x80', '\xff' })
+            {
+                std::string damaged = data;
+                damaged[i] ^= bits;
+                write_file(IMAGE, damaged);
+                CP_CHECK(!image.open(IMAGE, true));
+                if (image.open(IMAGE, false))
+                {
+                    read_all(image);
+                }
+            }
+        }
+    }
+} // anonymous
+
+int main()
+{
+    for (const ValueMode value_mode : { ValueMode::VALUE_EAGER, ValueMode::VALUE_LAZY })
+    {
+        ConfigParser p;
+        p.set_value_mode(value_mode);
+        p.add_boolean_word("ja", true);
+        CP_CHECK(p.parse_text(TEXT));
+
+        check_round_trip(p, true);
+        check_round_trip(p, false);
+        check_damaged(p);
+    }
+
+    check_compile();
+    std::remove(IMAGE);
+
+    return test::result();
+}
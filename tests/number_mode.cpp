@@ -0,0 +1,68 @@
+#include "check.h"
+#include <configparser.h>
+#include <climits> // LONG_MAX, LONG_MIN
+#include <cstdio> // snprintf
+#include <string>
+
+using namespace configparser;
+
+namespace
+{
+    const char* const TEXT =
+        "[a]\n"
+        "small = 42\n"
+        "list = 1, 2, 1.0e999, 4\n"
+        "big = 99999999999999999999\n";
+
+    ConfigParser make_parser(NumberMode number_mode, ValueMode value_mode)
+    {
+        ConfigParser p;
+        p.set_number_mode(number_mode);
+        p.set_value_mode(value_mode);
+        return p;
+    }
+
+    void check_modes(ValueMode value_mode)
+    {
+        // out of range numbers stay strings by default
+        ConfigParser lenient = make_parser(NumberMode::NUMBER_LENIENT, value_mode);
+        CP_CHECK(lenient.parse_text(TEXT));
+        CP_CHECK(lenient.option("a", "big").values()[0].has_type(ValueType::VALUE_STRING));
+        CP_CHECK(lenient.option("a", "list").values()[2].has_type(ValueType::VALUE_STRING));
+
+        ConfigParser strict = make_parser(NumberMode::NUMBER_STRICT, value_mode);
+        CP_CHECK(!strict.parse_text(TEXT));
+        CP_CHECK(strict.error_code() == ErrorCode::NUMBER_OUT_OF_RANGE);
+        CP_CHECK((strict.get_error_line() == 3) && (strict.get_error_column() == 15));
+
+        // the limits of a long (of whatever size) still fit, the
+        // next integers do not, in decimal and hexadecimal alike
+        const unsigned long past_max = (unsigned long)LONG_MAX + 1;
+        const std::string min = "[a]\nmin = " + std::to_string(LONG_MIN) + "\n";
+        CP_CHECK(strict.parse_text(min.c_str()));
+        CP_CHECK(strict.option("a", "min").get_long() == LONG_MIN);
+
+        const std::string max = "[a]\nmax = " + std::to_string(LONG_MAX) + "\n";
+        CP_CHECK(strict.parse_text(max.c_str()));
+        CP_CHECK(strict.option("a", "max").get_long() == LONG_MAX);
+
+        char hex[32];
+        std::snprintf(hex, sizeof(hex), "0x%lX", past_max);
+        for (const std::string& big : { std::to_string(past_max), std::string(hex) })
+        {
+            CP_CHECK(!strict.parse_text(("[a]\nbig = " + big + "\n").c_str()));
+            CP_CHECK(strict.error_code() == ErrorCode::NUMBER_OUT_OF_RANGE);
+        }
+
+        CP_CHECK(!strict.reparse_text("[a]\nbig = 0x10000000000000000\n"));
+        CP_CHECK(strict.error_code() == ErrorCode::NUMBER_OUT_OF_RANGE);
+    }
+} // anonymous
+
+int main()
+{
+    check_modes(ValueMode::VALUE_EAGER);
+    check_modes(ValueMode::VALUE_LAZY);
+
+    return test::result();
+}
@@ -0,0 +1,103 @@
+#include "check.h"
+#include <configparser.h>
+#include <cstdio> // fprintf
+#include <string>
+
+using namespace configparser;
+
+namespace
+{
+    struct setting_case
+    {
+        const char* name;
+        void (*apply)(ConfigParser& p);
+        const char* line; // of every section
+        const char* last; // of a section at the end, in the last part
+    }; // setting_case
+
+    const setting_case CASES[] = {
+        { "boolean words", [](ConfigParser& p) { p.add_boolean_word("ja", true); }, "v = ja", "w = JA" },
+        { "strict numbers", [](ConfigParser& p) { p.set_number_mode(NumberMode::NUMBER_STRICT); },
+            "v = 42", "big = 99999999999999999999" },
+        { "lazy values", [](ConfigParser& p) { p.set_value_mode(ValueMode::VALUE_LAZY); },
+            "v = 1, 2.5, on, text", "w = ${s0#v}" },
+        { "view document", [](ConfigParser& p) { p.set_document_mode(DocumentMode::DOCUMENT_VIEW); },
+            "v = text, \\ escaped\\ ", "w = text" },
+        { "interned names", [](ConfigParser& p) { p.set_intern_mode(InternMode::INTERN_ALL); },
+            "v = text", "v = text" },
+    };
+
+    // everything a setting can change about a document
+    std::string dump(const ConfigParser& p, bool ok)
+    {
+        std::string out = std::to_string(ok) + " " + std::to_string((int)p.error_code()) + " " +
+            std::to_string(p.get_error_line()) + ":" + std::to_string(p.get_error_column()) + "\n";
+        if (!ok)
+        {
+            return out;
+        }
+
+        // interned names are stored once, across parts as well
+        const char* first_name = p.sections()[0].options()[0].name().data();
+        for (const section_type& sct : p.sections())
+        {
+            for (const option_type& opt : sct.options())
+            {
+                out += std::string(sct.name()) + "#" + std::string(opt.name()) +
+                    ((opt.name().data() == first_name) ? " (first) =" : " =");
+                // lazy values are typed on first access, so resolution
+                // is looked at before the type
+                for (const value_type& val : opt.values())
+                {
+                    out += (val.is_resolved() ? " r" : " ");
+                    out += std::to_string((int)val.type()) + (val.is_borrowed() ? "b" : "") + ":" +
+                        (val.has_type(ValueType::VALUE_STRING) ? std::string(val.to_view()) : "");
+                }
+
+                out += "\n";
+            }
+        }
+
+        return out;
+    }
+
+    // large texts are parsed in parts, which take every setting
+    // of the parser, so the result is the one of a single thread
+    void check_case(const setting_case& c)
+    {
+        std::string text;
+        for (int i = 0; text.size() < 2 * 1024 * 1024; ++i)
+        {
+            text += "[s" + std::to_string(i) + "]\n" + c.line + "\n";
+        }
+
+        text += std::string("[last]\n") + c.last + "\n";
+
+        std::string results[2];
+        for (const unsigned thread_count : { 1u, 4u })
+        {
+            ConfigParser p;
+            c.apply(p);
+            p.set_thread_count(thread_count);
+            const bool ok = p.parse_text(text.c_str());
+            results[thread_count > 1] = dump(p, ok);
+        }
+
+        if (results[0] != results[1])
+        {
+            std::fprintf(stderr, "%s: parsed in parts differently\n", c.name);
+        }
+
+        CP_CHECK(results[0] == results[1]);
+    }
+} // anonymous
+
+int main()
+{
+    for (const setting_case& c : CASES)
+    {
+        check_case(c);
+    }
+
+    return test::result();
+}
@@ -0,0 +1,177 @@
+#include "check.h"
+#include <reloader.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio> // remove, rename
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace configparser;
+
+// many readers against frequent reloads, meant to be run with
+// -fsanitize=thread as well: every snapshot a reader sees must be
+// complete (all its options from the same version) and versions
+// must never go back
+namespace
+{
+    constexpr int READER_COUNT = 8;
+    constexpr int VERSION_COUNT = 200;
+    constexpr int SECTION_COUNT = 100;
+
+    // every 7th version does not parse and must never be seen
+    bool is_invalid(int version)
+    {
+        return (version % 7) == 0;
+    }
+
+    // written aside and renamed over, as editors do
+    void write_version(const std::string& path, int version)
+    {
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            out << "[main]\nversion = " << version << "\ncopy = ${main#version}\n";
+            for (int i = 0; i < SECTION_COUNT; ++i)
+            {
+                out << "[s" << i << "]\nv = " << version << '\n';
+            }
+
+            if (is_invalid(version))
+            {
+                out << "[unterminated\n";
+            }
+        }
+
+        std::rename(tmp.c_str(), path.c_str());
+    }
+
+    long read_long(const ConfigParser& p, std::string_view section, std::string_view option)
+    {
+        long value = -1;
+        const option_type* opt = p.find_option(section, option);
+        return ((opt != nullptr) && opt->get<long>(0, value)) ? value : -1;
+    }
+
+    struct reader_stats
+    {
+        std::atomic<long> reads{ 0 };
+        std::atomic<long> torn{ 0 };
+        std::atomic<long> backwards{ 0 };
+        std::atomic<long> invalid{ 0 };
+    }; // reader_stats
+
+    void read_until(const config_reloader& reloader, const std::atomic<bool>& done, reader_stats& stats)
+    {
+        snapshot_reader reader(reloader);
+        long last = -1;
+        while (!done.load(std::memory_order_relaxed))
+        {
+            const ConfigParser& p = reader.current();
+            const long version = read_long(p, "main", "version");
+            if (version >= 0)
+            {
+                if ((read_long(p, "main", "copy") != version) ||
+                    (read_long(p, "s" + std::to_string(SECTION_COUNT - 1), "v") != version))
+                {
+                    ++stats.torn;
+                }
+
+                if (version < last)
+                {
+                    ++stats.backwards;
+                }
+
+                if (is_invalid((int)version))
+                {
+                    ++stats.invalid;
+                }
+
+                last = version;
+            }
+
+            ++stats.reads;
+        }
+    }
+
+    // reloads driven by the writer, then by the watching thread
+    void stress(ValueMode value_mode)
+    {
+        const std::string path = "reloader_stress.ini";
+        write_version(path, 1);
+
+        ConfigParser settings;
+        settings.set_value_mode(value_mode);
+        config_reloader reloader(path, settings);
+        CP_CHECK(reloader.reload());
+
+        std::atomic<bool> done{ false };
+        reader_stats stats;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < READER_COUNT; ++i)
+        {
+            readers.emplace_back([&reloader, &done, &stats]() { read_until(reloader, done, stats); });
+        }
+
+        for (int version = 2; version <= VERSION_COUNT; ++version)
+        {
+            write_version(path, version);
+            CP_CHECK(reloader.reload() != is_invalid(version));
+            if (is_invalid(version))
+            {
+                CP_CHECK(reloader.error_code() != ErrorCode::NO_ERROR);
+            }
+        }
+
+        CP_CHECK(read_long(*reloader.snapshot(), "main", "version") == VERSION_COUNT);
+
+        // the same through the watching thread, where there is one
+        if (reloader.start())
+        {
+            const int last = 2 * VERSION_COUNT + 1;
+            for (int version = VERSION_COUNT + 1; version <= last; ++version)
+            {
+                write_version(path, version);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while ((read_long(*reloader.snapshot(), "main", "version") != last) &&
+                (std::chrono::steady_clock::now() < deadline))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            CP_CHECK(read_long(*reloader.snapshot(), "main", "version") == last);
+            reloader.stop();
+        }
+
+        done = true;
+        for (std::thread& t : readers)
+        {
+            t.join();
+        }
+
+        CP_CHECK(stats.reads > 0);
+        CP_CHECK(stats.torn == 0);
+        CP_CHECK(stats.backwards == 0);
+        CP_CHECK(stats.invalid == 0);
+
+        // a file that is gone keeps the last snapshot
+        const long published = read_long(*reloader.snapshot(), "main", "version");
+        std::remove(path.c_str());
+        CP_CHECK(!reloader.reload());
+        CP_CHECK(reloader.error_code() == ErrorCode::READ_ERROR);
+        CP_CHECK(read_long(*reloader.snapshot(), "main", "version") == published);
+    }
+} // anonymous
+
+int main()
+{
+    stress(ValueMode::VALUE_EAGER);
+    stress(ValueMode::VALUE_LAZY);
+
+    return test::result();
+}
@@ -0,0 +1,369 @@
+#include "check.h"
+#include <configparser.h>
+#include <algorithm> // remove_if
+#include <cstdio> // snprintf
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace configparser;
+
+namespace
+{
+    // a few names only, so sections and options are duplicated
+    // and links find other sections as the text changes
+    constexpr int SECTION_NAMES = 6;
+    constexpr int OPTION_NAMES = 4;
+
+    struct line_model
+    {
+        std::string text;
+        bool error;
+    }; // line_model
+
+    struct section_model
+    {
+        std::string name;
+        std::vector<line_model> lines;
+    }; // section_model
+
+    // a document edited one section at a time, as a reparse expects
+    class document_model
+    {
+    public:
+        document_model(unsigned seed, size_t filler) : m_random(seed), m_filler(filler)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                insert_section();
+            }
+        }
+
+        std::string text() const
+        {
+            std::string text;
+            for (const line_model& line : m_prefix)
+            {
+                text += line.text + "\n";
+            }
+
+            for (const section_model& sct : m_sections)
+            {
+                text += "[" + sct.name + "]\n";
+                for (const line_model& line : sct.lines)
+                {
+                    text += line.text + "\n";
+                }
+            }
+
+            return text;
+        }
+
+        void edit()
+        {
+            switch (pick(10))
+            {
+            case 0: insert_section(); break;
+            case 1: remove_section(); break;
+            case 2: move_section(); break;
+            case 3: rename_section(); break;
+            case 4: insert_line(random_option()); break;
+            case 5: insert_line(error_line()); break;
+            case 6: remove_line(); break;
+            case 7: repair(); break;
+            case 8: edit_prefix(); break;
+            default: change_line(); break;
+            }
+        }
+
+    private:
+        size_t pick(size_t count)
+        {
+            return std::uniform_int_distribution<size_t>(0, count - 1)(m_random);
+        }
+
+        std::string section_name()
+        {
+            return "s" + std::to_string(pick(SECTION_NAMES));
+        }
+
+        std::string option_name()
+        {
+            return "o" + std::to_string(pick(OPTION_NAMES));
+        }
+
+        std::string link()
+        {
+            return "${" + section_name() + "#" + option_name() + "}";
+        }
+
+        std::string value()
+        {
+            switch (pick(8))
+            {
+            case 0: return std::to_string((long)pick(100000) - 50000);
+            case 1: return std::to_string(pick(1000)) + ".25";
+            case 2: return pick(2) ? "on" : "no";
+            case 3: return "text " + std::to_string(pick(100));
+            case 4: return "1, two, " + std::to_string(pick(10));
+            case 5: return "a, " + link() + ", b";
+            default: return link();
+            }
+        }
+
+        line_model random_option()
+        {
+            return { option_name() + " = " + value(), false };
+        }
+
+        line_model error_line()
+        {
+            switch (pick(3))
+            {
+            case 0: return { "[unclosed", true };
+            case 1: return { "= " + value(), true };
+            default: return { option_name() + " = " + value() + " ]", true };
+            }
+        }
+
+        void insert_section()
+        {
+            section_model sct{ section_name(), {} };
+            for (size_t i = 0, count = 1 + pick(4); i < count; ++i)
+            {
+                sct.lines.push_back(random_option());
+            }
+
+            for (size_t i = 0; i < m_filler; ++i)
+            {
+                sct.lines.push_back({ "filler" + std::to_string(i) + " = some filler value " + std::to_string(i), false });
+            }
+
+            m_sections.insert(m_sections.begin() + pick(m_sections.size() + 1), std::move(sct));
+        }
+
+        void remove_section()
+        {
+            if (m_sections.size() > 1)
+            {
+                m_sections.erase(m_sections.begin() + pick(m_sections.size()));
+            }
+        }
+
+        // changes which of two equally named sections comes first
+        void move_section()
+        {
+            const size_t from = pick(m_sections.size());
+            section_model sct = std::move(m_sections[from]);
+            m_sections.erase(m_sections.begin() + from);
+            m_sections.insert(m_sections.begin() + pick(m_sections.size() + 1), std::move(sct));
+        }
+
+        void rename_section()
+        {
+            m_sections[pick(m_sections.size())].name = section_name();
+        }
+
+        void insert_line(line_model line)
+        {
+            std::vector<line_model>& lines = m_sections[pick(m_sections.size())].lines;
+            lines.insert(lines.begin() + pick(lines.size() + 1), std::move(line));
+        }
+
+        void remove_line()
+        {
+            std::vector<line_model>& lines = m_sections[pick(m_sections.size())].lines;
+            if (!lines.empty())
+            {
+                lines.erase(lines.begin() + pick(lines.size()));
+            }
+        }
+
+        void change_line()
+        {
+            std::vector<line_model>& lines = m_sections[pick(m_sections.size())].lines;
+            if (!lines.empty())
+            {
+                lines[pick(lines.size())] = random_option();
+            }
+        }
+
+        // the text before any section, an option there is an error
+        void edit_prefix()
+        {
+            if (!m_prefix.empty())
+            {
+                m_prefix.clear();
+            }
+            else if (pick(2))
+            {
+                m_prefix.push_back({ "; a comment", false });
+            }
+            else
+            {
+                m_prefix.push_back({ option_name() + " = 1", true });
+            }
+        }
+
+        // most edits should parse, so errors do not stay for long
+        void repair()
+        {
+            const auto is_error = [](const line_model& line) { return line.error; };
+            for (section_model& sct : m_sections)
+            {
+                sct.lines.erase(std::remove_if(sct.lines.begin(), sct.lines.end(), is_error), sct.lines.end());
+            }
+
+            m_prefix.erase(std::remove_if(m_prefix.begin(), m_prefix.end(), is_error), m_prefix.end());
+        }
+
+        std::mt19937 m_random;
+        size_t m_filler;
+        std::vector<line_model> m_prefix;
+        std::vector<section_model> m_sections;
+    }; // document_model
+
+    // everything a reader can tell about a document
+    std::string dump(const ConfigParser& p)
+    {
+        std::string out;
+        char number[32];
+        for (const section_type& sct : p.sections())
+        {
+            out += "[" + std::string(sct.name()) + "]\n";
+            for (const option_type& opt : sct.options())
+            {
+                out += std::string(opt.name()) + " =";
+                for (const value_type& val : opt.values())
+                {
+                    switch (val.type())
+                    {
+                    case ValueType::VALUE_LONG:
+                        out += " l:" + std::to_string(val.to_long());
+                        break;
+                    case ValueType::VALUE_DOUBLE:
+                        std::snprintf(number, sizeof(number), "%.17g", val.to_double());
+                        out += std::string(" d:") + number;
+                        break;
+                    case ValueType::VALUE_BOOLEAN:
+                        out += val.to_bool() ? " b:1" : " b:0";
+                        break;
+                    default:
+                        out += " s:" + std::string(val.to_view());
+                        break;
+                    }
+                }
+
+                out += "\n";
+            }
+        }
+
+        // a name is found at its first section
+        for (int i = 0; i < SECTION_NAMES; ++i)
+        {
+            const std::string name = "s" + std::to_string(i);
+            const section_type* sct = p.find_section(name);
+            size_t idx = 0;
+            while ((idx < p.sections().size()) && (&p.sections()[idx] != sct))
+            {
+                ++idx;
+            }
+
+            out += name + ":" + std::to_string(idx) + "\n";
+        }
+
+        return out;
+    }
+
+    struct mode
+    {
+        DocumentMode document_mode;
+        MemoryMode memory_mode;
+        ValueMode value_mode;
+        InternMode intern_mode;
+        bool frozen;
+        unsigned thread_count;
+        size_t filler; // options per section, to reach the size parsed in parts
+        int edits;
+    }; // mode
+
+    void set_mode(ConfigParser& p, const mode& m)
+    {
+        p.set_document_mode(m.document_mode);
+        p.set_memory_mode(m.memory_mode);
+        p.set_value_mode(m.value_mode);
+        p.set_intern_mode(m.intern_mode);
+        p.set_thread_count(m.thread_count);
+    }
+
+    // every reparse ends as a parse of the whole text would; the
+    // edits are many more than there are sections, so the bytes of
+    // replaced sections outweigh the live ones over and over
+    void check_edits(const mode& m, unsigned seed)
+    {
+        document_model model(seed, m.filler);
+        ConfigParser p;
+        set_mode(p, m);
+
+        ConfigParser kept; // a copy, which a reparse must leave alone
+        std::string kept_text = dump(kept);
+        for (int i = 0; i < m.edits; ++i)
+        {
+            const std::string text = model.text();
+            const bool ok = p.reparse_text(text.c_str());
+
+            ConfigParser fresh;
+            set_mode(fresh, m);
+            const bool fresh_ok = fresh.parse_text(text.c_str());
+
+            CP_CHECK(ok == fresh_ok);
+            CP_CHECK(p.error_code() == fresh.error_code());
+            // a successful parse leaves the position of an earlier error
+            if (!ok)
+            {
+                CP_CHECK(p.get_error_line() == fresh.get_error_line());
+                CP_CHECK(p.get_error_column() == fresh.get_error_column());
+            }
+            else
+            {
+                CP_CHECK(dump(p) == dump(fresh));
+                if (m.frozen && !p.is_frozen())
+                {
+                    p.freeze();
+                }
+            }
+
+            CP_CHECK(dump(kept) == kept_text);
+            if (i % 16 == 0)
+            {
+                kept = p;
+                kept_text = dump(kept);
+            }
+
+            model.edit();
+        }
+    }
+} // anonymous
+
+int main()
+{
+    const mode modes[] = {
+        { DocumentMode::DOCUMENT_COPY, MemoryMode::MEMORY_HEAP, ValueMode::VALUE_EAGER, InternMode::INTERN_NONE, false, 1, 0, 300 },
+        { DocumentMode::DOCUMENT_VIEW, MemoryMode::MEMORY_HEAP, ValueMode::VALUE_LAZY, InternMode::INTERN_NONE, true, 1, 0, 300 },
+        { DocumentMode::DOCUMENT_COPY, MemoryMode::MEMORY_ARENA, ValueMode::VALUE_EAGER, InternMode::INTERN_ALL, false, 1, 0, 300 },
+        { DocumentMode::DOCUMENT_VIEW, MemoryMode::MEMORY_ARENA, ValueMode::VALUE_LAZY, InternMode::INTERN_NAMES, true, 1, 0, 300 },
+        // large enough to be parsed, and reparsed, in parts
+        { DocumentMode::DOCUMENT_COPY, MemoryMode::MEMORY_HEAP, ValueMode::VALUE_LAZY, InternMode::INTERN_NONE, false, 4, 4000, 16 },
+        { DocumentMode::DOCUMENT_VIEW, MemoryMode::MEMORY_HEAP, ValueMode::VALUE_EAGER, InternMode::INTERN_ALL, true, 4, 4000, 16 },
+    };
+
+    for (const mode& m : modes)
+    {
+        for (unsigned seed = 1; seed <= 4; ++seed)
+        {
+            check_edits(m, seed);
+        }
+    }
+
+    return test::result();
+}
@@ -0,0 +1,52 @@
+#include "check.h"
+#include <value_type.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace configparser;
+
+namespace
+{
+    template <typename Fn>
+    bool throws_length_error(Fn fn)
+    {
+        try
+        {
+            fn();
+        }
+        catch (const std::length_error&)
+        {
+            return true;
+        }
+
+        return false;
+    }
+} // anonymous
+
+int main()
+{
+    // the size is checked before the text is read, so it needs no memory
+    const char text[] = "borrowed";
+    const std::string_view huge(text, (size_t)value_type::MAX_BORROWED_SIZE + 1);
+    CP_CHECK(throws_length_error([&huge]() { (void)value_type::from_view(huge); }));
+    CP_CHECK(throws_length_error([&huge]() { (void)value_type::from_raw(huge, true); }));
+
+    const value_type borrowed = value_type::from_view(text);
+    CP_CHECK(borrowed.is_borrowed() && (borrowed.to_view() == "borrowed"));
+
+    // moved values keep their string, the moved ones are empty
+    value_type owned(std::string("owned"));
+    value_type moved(std::move(owned));
+    CP_CHECK(moved.to_str() == "owned");
+
+    value_type copy = moved;
+    moved = value_type(42L);
+    CP_CHECK((copy.to_str() == "owned") && (moved.to_long() == 42));
+
+    value_type lazy = value_type::from_raw("0x10", false);
+    value_type lazy_moved(std::move(lazy));
+    CP_CHECK(!lazy_moved.is_resolved() && (lazy_moved.to_long() == 16));
+
+    return test::result();
+}
@@ -0,0 +1,98 @@
+#include "check.h"
+#include <configparser.h>
+#include <stdexcept>
+#include <string>
+
+using namespace configparser;
+
+namespace
+{
+    const char* const TEXT =
+        "[a]\n"
+        "host = example.org\n"
+        "padded = \\ spaced out\\ \n"
+        "port = 8080\n"
+        "list = one, two, three, four\n";
+
+    bool throws_logic_error(const option_type& opt, size_t idx)
+    {
+        try
+        {
+            (void)opt.get_str(idx);
+        }
+        catch (const std::logic_error&)
+        {
+            return true;
+        }
+
+        return false;
+    }
+
+    void check_document(DocumentMode document_mode, ValueMode value_mode, MemoryMode memory_mode)
+    {
+        ConfigParser p;
+        p.set_document_mode(document_mode);
+        p.set_value_mode(value_mode);
+        p.set_memory_mode(memory_mode);
+        CP_CHECK(p.parse_text(TEXT));
+
+        const bool view = document_mode == DocumentMode::DOCUMENT_VIEW;
+
+        std::string str;
+        const option_type& host = p.option("a", "host");
+        CP_CHECK(host.get<std::string>(0, str) && (str == "example.org"));
+        CP_CHECK(host.get_view() == "example.org");
+        CP_CHECK(host.values()[0].is_borrowed() == view);
+        CP_CHECK(throws_logic_error(host, 0) == view);
+        if (!view)
+        {
+            CP_CHECK(host.get_str() == "example.org");
+        }
+
+        const option_type& padded = p.option("a", "padded");
+        CP_CHECK(padded.get<std::string>(0, str) && (str == " spaced out "));
+        CP_CHECK(padded.get_view() == " spaced out ");
+        // escaped strings are copied in lazy mode
+        CP_CHECK(throws_logic_error(padded, 0) == padded.values()[0].is_borrowed());
+
+        const option_type& port = p.option("a", "port");
+        CP_CHECK(!port.get<std::string>(0, str));
+        CP_CHECK(port.get_long() == 8080);
+
+        const option_type& list = p.option("a", "list");
+        for (size_t i = 0; i < list.size(); ++i)
+        {
+            CP_CHECK(list.get<std::string>(i, str) && (str == list.get_view(i)));
+        }
+
+        // copies of a parser share its text
+        const ConfigParser copy = p;
+        CP_CHECK(copy.option("a", "host").get<std::string>(0, str) && (str == "example.org"));
+
+        // and assigning over a parsed document releases it first
+        ConfigParser assigned;
+        assigned.set_memory_mode(memory_mode);
+        CP_CHECK(assigned.parse_text("[b]\nx = 1\n"));
+        assigned = copy;
+        CP_CHECK(assigned.option("a", "host").get_view() == "example.org");
+        assigned = std::move(p);
+        CP_CHECK(assigned.option("a", "list").get_view(1) == "two");
+        CP_CHECK(!assigned.has_section("b"));
+    }
+} // anonymous
+
+int main()
+{
+    for (const DocumentMode document_mode : { DocumentMode::DOCUMENT_COPY, DocumentMode::DOCUMENT_VIEW })
+    {
+        for (const ValueMode value_mode : { ValueMode::VALUE_EAGER, ValueMode::VALUE_LAZY })
+        {
+            for (const MemoryMode memory_mode : { MemoryMode::MEMORY_HEAP, MemoryMode::MEMORY_ARENA })
+            {
+                check_document(document_mode, value_mode, memory_mode);
+            }
+        }
+    }
+
+    return test::result();
+}